@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Compara duas execuções do firmware_bench (linhas JSON) e aponta regressões.
+
+    python3 bench/compara.py base.jsonl atual.jsonl [--limite 0.10]
+
+Compara a mediana (p50) de cada caso com o mesmo alvo e unidade. Linhas que não são JSON (por
+exemplo, o log da placa pela serial) são ignoradas. Sai com código 1 se algum caso ficou mais
+lento que o limite ou sumiu da execução atual.
+"""
+
+import argparse
+import json
+import sys
+
+
+def le(caminho):
+    resultados = {}
+    with open(caminho, encoding="utf-8", errors="replace") as f:
+        for linha in f:
+            linha = linha.strip()
+            if not linha.startswith("{"):
+                continue
+            try:
+                r = json.loads(linha)
+            except json.JSONDecodeError:
+                continue
+            if "caso" in r:
+                resultados[(r["alvo"], r["caso"])] = r
+    return resultados
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("base")
+    p.add_argument("atual")
+    p.add_argument("--limite", type=float, default=0.10,
+                   help="aumento relativo do p50 tolerado (padrão: 0.10)")
+    args = p.parse_args()
+
+    base, atual = le(args.base), le(args.atual)
+    regressoes = 0
+
+    print(f"{'alvo':8} {'caso':28} {'base':>10} {'atual':>10} {'razão':>7}")
+    for chave in sorted(base):
+        b = base[chave]
+        a = atual.get(chave)
+        if a is None:
+            print(f"{chave[0]:8} {chave[1]:28} {b['p50']:10.1f} {'-':>10} {'-':>7}  SUMIU")
+            regressoes += 1
+            continue
+        if a["unidade"] != b["unidade"]:
+            print(f"{chave[0]:8} {chave[1]:28} unidades diferentes ({b['unidade']} x {a['unidade']})")
+            continue
+
+        razao = a["p50"] / b["p50"] if b["p50"] > 0 else 1.0
+        marca = ""
+        if razao > 1 + args.limite:
+            marca = "  REGRESSÃO"
+            regressoes += 1
+        elif razao < 1 - args.limite:
+            marca = "  melhora"
+        print(f"{chave[0]:8} {chave[1]:28} {b['p50']:10.1f} {a['p50']:10.1f} {razao:6.2f}x{marca}")
+
+    for chave in sorted(set(atual) - set(base)):
+        print(f"{chave[0]:8} {chave[1]:28} {'-':>10} {atual[chave]['p50']:10.1f} {'-':>7}  novo")
+
+    return 1 if regressoes else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,200 @@
+// Benchmark dos caminhos quentes do firmware, no host e na placa (RP2040, medido em ciclos pelo
+// SysTick). Cada caso roda AMOSTRAS lotes de chamadas e imprime uma linha JSON com o custo por
+// chamada (mínimo, mediana e máximo dos lotes), para comparar execuções com bench/compara.py:
+//
+//   cmake -S bench -B build-bench && cmake --build build-bench
+//   ./build-bench/firmware_bench > atual.jsonl
+//   python3 bench/compara.py base.jsonl atual.jsonl
+//
+// Na placa: cmake -DROBOVIGIA_BENCH=ON gera o RoboVigiaBench.uf2, que imprime as mesmas linhas
+// pela USB (e pela UART) assim que o terminal é aberto.
+//
+// Vários dos caminhos medidos são funções static de main.c, por isso main.c é incluído aqui, com
+// o main() do firmware renomeado; os periféricos são iniciados como no setup(), mas sem o
+// núcleo 1 e sem o Wi-Fi.
+
+#define main robovigia_main
+#include "../main.c"
+#undef main
+
+#include "medida.h"
+
+#define AMOSTRAS 21   // Lotes por caso (ímpar: a mediana é um dos lotes)
+
+// Definidos em lib/neopixel.c, fora do neopixel.h
+extern npLED_t leds[LED_COUNT];
+uint32_t encode_rgb(npLED_t cor);
+
+static volatile uint32_t sorvedouro;   // Impede que o compilador descarte resultados
+static conexao_t con_bench;
+static quadro_t quadro_bench;
+
+//====================================
+//      Casos
+//====================================
+
+// Quadro publicado pelo núcleo 0, com a visibilidade vinda da cache (o caso comum: o robô anda
+// entre posições já vistas). O quadro é consumido logo em seguida, no lugar do núcleo 1.
+static void caso_atualiza_leds(uint32_t i) {
+    mundo.robo_x = 2 + (i & 1);
+    atualiza_leds();
+    if (spsc_proximo(&fila_quadros) >= 0) spsc_consome(&fila_quadros);
+}
+
+// O mesmo, com a cache de visibilidade vazia: inclui o shadowcasting do mapa inteiro
+static void caso_atualiza_leds_fov(uint32_t i) {
+    for (int e = 0; e < VIS_CACHE_ENTRADAS; e++) vis_cache[e].versao = 0;
+    caso_atualiza_leds(i);
+}
+
+static void caso_obstaculo_entre(uint32_t i) {
+    int a = i % MAPA_LARGURA;
+    sorvedouro += mapa_tem_obstaculo_entre(&mapa, a, 0, MAPA_LARGURA - 1 - a, MAPA_ALTURA - 1);
+}
+
+// Codificação GRB da matriz inteira, como npWrite() faz a cada quadro
+static void caso_encode_rgb(uint32_t i) {
+    uint32_t soma = i;
+    for (int k = 0; k < LED_COUNT; k++) soma += encode_rgb(leds[k]);
+    sorvedouro += soma;
+}
+
+// Quadro com o último LED alterado: codifica, compara e envia os 25 pixels
+static void caso_npwrite(uint32_t i) {
+    npSetLED(LED_COUNT - 1, i & 1 ? 20 : 0, 0, 0);
+    npWrite();
+}
+
+// Quadro igual ao anterior: só a codificação e a comparação
+static void caso_npwrite_igual(uint32_t i) {
+    npWrite();
+}
+
+// Desenho da matriz no núcleo 1 (cores de cada célula e npWrite())
+static void caso_desenha_matriz(uint32_t i) {
+    quadro_bench.robo_vx = i & 1 ? 2 : 3;
+    desenha_matriz(&quadro_bench);
+}
+
+// Painel de estado do display, redesenhado por inteiro (a posição muda a cada chamada)
+static void caso_desenha_display(uint32_t i) {
+    quadro_bench.mundo.robo_x = i & 1 ? 2 : 3;
+    desenha_display(&quadro_bench);
+}
+
+static void caso_ssd1306_fill(uint32_t i) {
+    ssd1306_fill(&ssd, i & 1);
+}
+
+static void caso_draw_string_alinhado(uint32_t i) {
+    ssd1306_draw_string(&ssd, "Servidor Ativo", 0, 16);
+}
+
+// Linhas do painel em y = 28, 40 e 52 não caem numa página do display
+static void caso_draw_string_desalinhado(uint32_t i) {
+    ssd1306_draw_string(&ssd, "Servidor Ativo", 0, 28);
+}
+
+// Bloco variável da página de controle (snprintf)
+static void caso_pagina_snprintf(uint32_t i) {
+    mundo.robo_x = 2 + (i & 1);
+    sorvedouro += formata_informacoes(con_bench.dinamico + HTTP_EXTRA_TAM, HTTP_DINAMICO_TAM - HTTP_EXTRA_TAM);
+}
+
+// Resposta inteira da página: cabeçalho com Content-Length, bloco variável e fila de saída
+static void caso_responde_pagina(uint32_t i) {
+    mundo.robo_x = 2 + (i & 1);
+    responde_pagina(&con_bench);
+    saida_descarta(&con_bench.saida);
+}
+
+typedef struct {
+    const char *nome;
+    void (*executa)(uint32_t i);
+    uint32_t lote;   // Chamadas por medida (o lote inteiro deve caber no SysTick)
+} caso_t;
+
+static const caso_t casos[] = {
+    { "atualiza_leds",              caso_atualiza_leds,            64 },
+    { "atualiza_leds_fov",          caso_atualiza_leds_fov,        64 },
+    { "mapa_tem_obstaculo_entre",   caso_obstaculo_entre,          256 },
+    { "encode_rgb_matriz",          caso_encode_rgb,               256 },
+    { "npWrite",                    caso_npwrite,                  64 },
+    { "npWrite_igual",              caso_npwrite_igual,            64 },
+    { "desenha_matriz",             caso_desenha_matriz,           64 },
+    { "desenha_display",            caso_desenha_display,          16 },
+    { "ssd1306_fill",               caso_ssd1306_fill,             64 },
+    { "ssd1306_draw_string",        caso_draw_string_alinhado,     64 },
+    { "ssd1306_draw_string_desal",  caso_draw_string_desalinhado,  64 },
+    { "pagina_snprintf",            caso_pagina_snprintf,          64 },
+    { "responde_pagina",            caso_responde_pagina,          64 },
+};
+
+#define NUM_CASOS (sizeof(casos) / sizeof(casos[0]))
+
+//====================================
+//      Medida
+//====================================
+
+static int compara_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// Função para medir um caso e imprimir o resultado (custo por chamada) em uma linha JSON
+static void mede(const caso_t *c) {
+    float por_chamada[AMOSTRAS];
+
+    for (uint32_t i = 0; i < c->lote; i++) c->executa(i);   // Aquece caches e estado
+
+    for (int a = 0; a < AMOSTRAS; a++) {
+        uint32_t inicio = medida_agora();
+        for (uint32_t i = 0; i < c->lote; i++) c->executa(i);
+        por_chamada[a] = (float)medida_decorrido(inicio) / c->lote;
+    }
+    qsort(por_chamada, AMOSTRAS, sizeof(float), compara_float);
+
+    printf("{\"caso\":\"%s\",\"alvo\":\"%s\",\"unidade\":\"%s\",\"lote\":%lu,\"amostras\":%d,"
+           "\"min\":%.1f,\"p50\":%.1f,\"max\":%.1f}\n",
+           c->nome, MEDIDA_ALVO, MEDIDA_UNIDADE, (unsigned long)c->lote, AMOSTRAS,
+           por_chamada[0], por_chamada[AMOSTRAS / 2], por_chamada[AMOSTRAS - 1]);
+}
+
+// Função para preparar o estado e os periféricos usados pelos casos (como no setup())
+static bool prepara(void) {
+    if (!mapa_carrega(&mapa, mapa_inicial, MAPA_LARGURA, MAPA_ALTURA) || !visibilidade_init()) {
+        printf("Falha ao alocar o mapa\n");
+        return false;
+    }
+    npInit(LED_PIN);
+    display_init(&ssd);
+    spsc_init(&fila_quadros, QUADROS_FILA);
+    saida_init(&con_bench.saida, NULL);
+
+    quadro_bench.mundo = mundo;
+    for (int vy = 0; vy < VIEWPORT_TAM; vy++) {
+        for (int vx = 0; vx < VIEWPORT_TAM; vx++) {
+            quadro_bench.celulas[vy][vx] = mapa_get(&mapa, vx, vy);
+        }
+    }
+    return true;
+}
+
+int main(void) {
+    stdio_init_all();
+#if PICO_ON_DEVICE
+    // Espera o terminal da USB (até 10 s) para que as linhas não se percam
+    for (int i = 0; i < 100 && !stdio_usb_connected(); i++) sleep_ms(100);
+#endif
+
+    if (!prepara()) return -1;
+    medida_init();
+
+    for (size_t i = 0; i < NUM_CASOS; i++) mede(&casos[i]);
+    printf("{\"fim\":true,\"casos\":%u}\n", (unsigned)NUM_CASOS);
+
+#if PICO_ON_DEVICE
+    while (true) sleep_ms(1000);
+#endif
+    return 0;
+}
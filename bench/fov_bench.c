@@ -0,0 +1,89 @@
+// Benchmark (host) do cálculo de visibilidade do mapa inteiro:
+// um raio de Bresenham por célula (mapa_tem_obstaculo_entre) x shadowcasting simétrico (fov_calcula).
+//
+//   cmake -S bench -B build-bench && cmake --build build-bench && ./build-bench/fov_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mapa.h"
+#include "fov.h"
+
+static double agora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Visibilidade como o atualiza_leds() calculava antes: um raio por célula
+static void visibilidade_bresenham(const mapa_t *m, int x, int y, uint32_t *bits, uint16_t palavras) {
+    memset(bits, 0, palavras * sizeof(uint32_t));
+    for (int cy = 0; cy < m->altura; cy++) {
+        for (int cx = 0; cx < m->largura; cx++) {
+            if (mapa_get(m, cx, cy) == OBSTACULO || !mapa_tem_obstaculo_entre(m, x, y, cx, cy)) {
+                uint32_t i = (uint32_t)cy * m->largura + cx;
+                bits[i >> 5] |= 1u << (i & 31);
+            }
+        }
+    }
+}
+
+// Gera um mapa com ~densidade% de obstáculos, deixando livre o centro (posição do robô)
+static void gera_mapa(mapa_t *m, uint16_t lado, int densidade, unsigned semente) {
+    mapa_init(m, lado, lado);
+    srand(semente);
+    for (int y = 0; y < lado; y++)
+        for (int x = 0; x < lado; x++)
+            if (rand() % 100 < densidade) mapa_set(m, x, y, OBSTACULO);
+    mapa_set(m, lado / 2, lado / 2, VAZIO);
+}
+
+static void executa(uint16_t lado, int iteracoes) {
+    mapa_t m;
+    fov_t f;
+    gera_mapa(&m, lado, 20, 1234);
+    fov_init(&f, &m);
+
+    uint32_t *a = malloc(f.palavras * sizeof(uint32_t));
+    uint32_t *b = malloc(f.palavras * sizeof(uint32_t));
+    int rx = lado / 2, ry = lado / 2;
+
+    double t0 = agora_ns();
+    for (int i = 0; i < iteracoes; i++) visibilidade_bresenham(&m, rx, ry, a, f.palavras);
+    double t_bres = (agora_ns() - t0) / iteracoes;
+
+    t0 = agora_ns();
+    for (int i = 0; i < iteracoes; i++) fov_calcula(&f, &m, rx, ry, b);
+    double t_fov = (agora_ns() - t0) / iteracoes;
+
+    // Concordância entre os dois métodos nas células livres (shadowcasting é simétrico, Bresenham
+    // não; e o método antigo considera todo obstáculo visível)
+    uint32_t livres = 0, iguais = 0, vis_a = 0, vis_b = 0;
+    for (uint32_t i = 0; i < (uint32_t)lado * lado; i++) {
+        if (mapa_get(&m, i % lado, i / lado) == OBSTACULO) continue;
+        int va = (a[i >> 5] >> (i & 31)) & 1, vb = (b[i >> 5] >> (i & 31)) & 1;
+        livres++;
+        iguais += va == vb;
+        vis_a += va;
+        vis_b += vb;
+    }
+
+    printf("%3ux%-3u %12.0f %12.0f %8.1fx %8u %8u %7.1f%%\n", lado, lado, t_bres, t_fov,
+           t_bres / t_fov, vis_a, vis_b, 100.0 * iguais / livres);
+
+    free(a);
+    free(b);
+    fov_free(&f);
+    mapa_free(&m);
+}
+
+int main(void) {
+    printf("%-7s %12s %12s %9s %8s %8s %8s\n", "mapa", "bresenham_ns", "fov_ns", "ganho",
+           "vis_bres", "vis_fov", "iguais");
+    executa(5, 200000);
+    executa(64, 200);
+    executa(256, 5);
+    return 0;
+}
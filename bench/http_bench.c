@@ -0,0 +1,106 @@
+// Benchmark (host) do parser HTTP incremental de lib/http.c, em requisições por segundo, contra
+// a abordagem antiga: copiar o segmento para uma string terminada em '\0' e procurar a rota com
+// a cadeia de strstr de user_request() e o Connection com uma busca por linha.
+//
+//   cmake -S bench -B build-bench && cmake --build build-bench && ./build-bench/http_bench
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "http.h"
+
+#define REPETICOES 200000
+
+static double agora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// A mesma tabela de main.c
+static const http_rota_t rotas[] = {
+    { "GET /", 1 }, { "GET /capturar", 'P' }, { "GET /coleta", 'C' }, { "GET /down", 'D' },
+    { "GET /entrega", 'E' }, { "GET /events", 3 }, { "GET /left", 'L' }, { "GET /right", 'R' },
+    { "GET /state", 2 }, { "GET /up", 'U' }, { "GET /ws", 4 },
+};
+#define NUM_ROTAS (sizeof(rotas) / sizeof(rotas[0]))
+
+// Requisição típica de um navegador
+static const char requisicao[] =
+    "GET /coleta HTTP/1.1\r\n"
+    "Host: 192.168.0.50\r\n"
+    "Connection: keep-alive\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Referer: http://192.168.0.50/up\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: pt-BR,pt;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+    "\r\n";
+
+// Referência: como era antes (string terminada em '\0' + strstr)
+static int ref_rota(const char *request) {
+    if (strstr(request, "GET /up") != NULL) return 'U';
+    else if (strstr(request, "GET /down") != NULL) return 'D';
+    else if (strstr(request, "GET /left") != NULL) return 'L';
+    else if (strstr(request, "GET /right") != NULL) return 'R';
+    else if (strstr(request, "GET /capturar") != NULL) return 'P';
+    else if (strstr(request, "GET /entrega") != NULL) return 'E';
+    else if (strstr(request, "GET /coleta") != NULL) return 'C';
+    return 0;
+}
+
+static int ref_fecha(const char *request) {
+    for (const char *l = request; l && *l; l = strchr(l, '\n'), l = l ? l + 1 : NULL) {
+        if (strncasecmp(l, "Connection:", 11) == 0) return strncasecmp(l + 12, "close", 5) == 0;
+    }
+    return 0;
+}
+
+static volatile int sumidouro;
+
+// Alimenta o parser em pedaços de `pedaco` bytes (simulando pbufs de uma cadeia)
+static double mede_parser(size_t pedaco) {
+    http_parser_t p;
+    size_t tam = sizeof(requisicao) - 1;
+    http_parser_init(&p, rotas, NUM_ROTAS);
+
+    double t0 = agora_ns();
+    for (int n = 0; n < REPETICOES; n++) {
+        for (size_t off = 0; off < tam;) {
+            size_t resto = tam - off < pedaco ? tam - off : pedaco, usados;
+            while (resto > 0) {
+                if (http_parser_alimenta(&p, requisicao + off, resto, &usados) == HTTP_COMPLETA) {
+                    sumidouro += rotas[p.rota].id + http_fecha_apos(&p);
+                    http_parser_reinicia(&p);
+                }
+                off += usados;
+                resto -= usados;
+            }
+        }
+    }
+    return REPETICOES / ((agora_ns() - t0) / 1e9);
+}
+
+static double mede_referencia(void) {
+    char copia[sizeof(requisicao)];
+
+    double t0 = agora_ns();
+    for (int n = 0; n < REPETICOES; n++) {
+        memcpy(copia, requisicao, sizeof(requisicao));
+        sumidouro += ref_rota(copia) + ref_fecha(copia);
+    }
+    return REPETICOES / ((agora_ns() - t0) / 1e9);
+}
+
+int main(void) {
+    printf("requisicao de %zu bytes, %d repeticoes\n", sizeof(requisicao) - 1, REPETICOES);
+    printf("%-28s %12s\n", "metodo", "req/s");
+    printf("%-28s %12.0f\n", "strstr (antigo)", mede_referencia());
+    printf("%-28s %12.0f\n", "parser, 1 pbuf", mede_parser(sizeof(requisicao)));
+    printf("%-28s %12.0f\n", "parser, pbufs de 64 bytes", mede_parser(64));
+    printf("%-28s %12.0f\n", "parser, 1 byte por vez", mede_parser(1));
+    return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef MEDIDA_H
+#define MEDIDA_H
+
+#include <stdint.h>
+
+// Relógio dos benchmarks que rodam tanto no host quanto na placa. Na placa é o SysTick do
+// Cortex-M0+ (o M0+ não tem o contador de ciclos do DWT): um contador decrescente de 24 bits no
+// clock do processador, que dá a volta a cada ~134 ms a 125 MHz, então cada medida deve ser mais
+// curta que isso. No host é o relógio monotônico, em ns.
+
+#if PICO_ON_DEVICE
+
+#include "hardware/structs/systick.h"
+
+#define MEDIDA_ALVO "rp2040"
+#define MEDIDA_UNIDADE "ciclos"
+#define MEDIDA_MAX 0x00FFFFFFu
+
+static inline void medida_init(void) {
+    systick_hw->rvr = MEDIDA_MAX;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;   // ENABLE | CLKSOURCE (clock do processador), sem interrupção
+}
+
+static inline uint32_t medida_agora(void) {
+    return systick_hw->cvr;
+}
+
+static inline uint32_t medida_decorrido(uint32_t inicio) {
+    return (inicio - systick_hw->cvr) & MEDIDA_MAX;
+}
+
+#else
+
+#include <time.h>
+
+#define MEDIDA_ALVO "host"
+#define MEDIDA_UNIDADE "ns"
+#define MEDIDA_MAX 0xFFFFFFFFu
+
+static inline void medida_init(void) {
+}
+
+static inline uint32_t medida_agora(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+static inline uint32_t medida_decorrido(uint32_t inicio) {
+    return medida_agora() - inicio;
+}
+
+#endif
+
+#endif // MEDIDA_H
@@ -0,0 +1,124 @@
+// Benchmark (host) das primitivas de desenho do SSD1306: versões pixel a pixel (como eram antes)
+// x caminhos rápidos por byte/página de lib/ssd1306.c.
+//
+//   cmake -S bench -B build-bench && cmake --build build-bench && ./build-bench/raster_bench
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssd1306.h"
+#include "font.h"
+
+static double agora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Implementações de referência, pixel a pixel
+static void ref_fill(ssd1306_t *ssd, bool value) {
+    for (uint8_t y = 0; y < ssd->height; ++y)
+        for (uint8_t x = 0; x < ssd->width; ++x)
+            ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
+    for (uint8_t x = x0; x <= x1; ++x)
+        ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+    for (uint8_t y = y0; y <= y1; ++y)
+        ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
+    for (uint8_t x = left; x < left + width; ++x) {
+        ssd1306_pixel(ssd, x, top, value);
+        ssd1306_pixel(ssd, x, top + height - 1, value);
+    }
+    for (uint8_t y = top; y < top + height; ++y) {
+        ssd1306_pixel(ssd, left, y, value);
+        ssd1306_pixel(ssd, left + width - 1, y, value);
+    }
+    if (fill)
+        for (uint8_t x = left + 1; x < left + width - 1; ++x)
+            for (uint8_t y = top + 1; y < top + height - 1; ++y)
+                ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y) {
+    uint16_t index = (c >= ' ' && c <= '~') ? (c - ' ') * 8 : 0;
+    for (uint8_t i = 0; i < 8; ++i) {
+        uint8_t line = font[index + i];
+        for (uint8_t j = 0; j < 8; ++j)
+            ssd1306_pixel(ssd, x + i, y + j, line & (1 << j));
+    }
+}
+
+static void ref_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y) {
+    while (*str) {
+        ref_draw_char(ssd, *str++, x, y);
+        x += 8;
+        if (x + 8 >= ssd->width) { x = 0; y += 8; }
+        if (y + 8 >= ssd->height) break;
+    }
+}
+
+#define ITERACOES 20000
+
+// Mede o tempo médio (ns) de uma chamada; CASO recebe o índice da iteração em i
+#define MEDE(resultado, CASO)                               \
+    do {                                                    \
+        double t0 = agora_ns();                             \
+        for (int i = 0; i < ITERACOES; i++) { CASO; }       \
+        resultado = (agora_ns() - t0) / ITERACOES;          \
+    } while (0)
+
+static ssd1306_t ssd;
+
+static void linha(const char *nome, double ref, double rapido) {
+    printf("%-22s %10.1f %10.1f %8.1fx\n", nome, ref, rapido, ref / rapido);
+}
+
+int main(void) {
+    double a, b;
+    ssd1306_init(&ssd, WIDTH, HEIGHT, false, endereco, I2C_PORT);
+
+    printf("%-22s %10s %10s %9s\n", "primitiva", "pixel_ns", "rapido_ns", "ganho");
+
+    MEDE(a, ref_fill(&ssd, i & 1));
+    MEDE(b, ssd1306_fill(&ssd, i & 1));
+    linha("fill", a, b);
+
+    MEDE(a, ref_draw_char(&ssd, 'A' + (i & 15), 8 * (i & 15), 24));
+    MEDE(b, ssd1306_draw_char(&ssd, 'A' + (i & 15), 8 * (i & 15), 24));
+    linha("draw_char alinhado", a, b);
+
+    MEDE(a, ref_draw_char(&ssd, 'A' + (i & 15), 8 * (i & 15), 28));
+    MEDE(b, ssd1306_draw_char(&ssd, 'A' + (i & 15), 8 * (i & 15), 28));
+    linha("draw_char desalinhado", a, b);
+
+    MEDE(a, ref_draw_string(&ssd, " Servidor Ativo ", 0, 28));
+    MEDE(b, ssd1306_draw_string(&ssd, " Servidor Ativo ", 0, 28));
+    linha("draw_string", a, b);
+
+    MEDE(a, ref_hline(&ssd, 0, 127, i & 63, i & 1));
+    MEDE(b, ssd1306_hline(&ssd, 0, 127, i & 63, i & 1));
+    linha("hline 128", a, b);
+
+    MEDE(a, ref_vline(&ssd, i & 127, 0, 63, i & 1));
+    MEDE(b, ssd1306_vline(&ssd, i & 127, 0, 63, i & 1));
+    linha("vline 64", a, b);
+
+    MEDE(a, ref_rect(&ssd, 3, 3, 120, 58, i & 1, false));
+    MEDE(b, ssd1306_rect(&ssd, 3, 3, 120, 58, i & 1, false));
+    linha("rect contorno", a, b);
+
+    MEDE(a, ref_rect(&ssd, 3, 3, 120, 58, i & 1, true));
+    MEDE(b, ssd1306_rect(&ssd, 3, 3, 120, 58, i & 1, true));
+    linha("rect cheio", a, b);
+
+    return 0;
+}
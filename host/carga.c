@@ -0,0 +1,300 @@
+// Gerador de carga HTTP para o servidor do firmware: abre N conexões em paralelo (uma thread
+// cada), como N navegadores, e repete as rotas pedidas até o tempo acabar. No fim, imprime por
+// rota as requisições por segundo, a latência (p50, p99 e máximo) e os erros. Funciona contra a
+// simulação (robovigia_sim -p PORTA) ou contra a placa:
+//
+//   robovigia_carga [-h IP] [-p PORTA] [-c CONEXOES] [-d SEGUNDOS] [-f] [-r CAMINHO]... [-j]
+//
+//   -h IP        endereço do servidor (padrão 127.0.0.1)
+//   -p PORTA     porta do servidor (padrão 80)
+//   -c CONEXOES  conexões simultâneas (padrão 10)
+//   -d SEGUNDOS  duração (padrão 5)
+//   -f           uma conexão nova por requisição (Connection: close) em vez de keep-alive
+//   -r CAMINHO   rota a pedir (pode repetir; padrão "/", "/cmd?seq=R" e "/cmd?seq=L")
+//   -j           imprime o resultado em linhas JSON
+//
+// A latência vai do envio da requisição (ou do connect(), com -f) ao último byte da resposta.
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CARGA_ROTAS_MAX 16
+#define CARGA_CONEXOES_MAX 256
+#define CARGA_CABECALHO_MAX 4096
+#define CARGA_TIMEOUT_S 5
+#define CARGA_RECUSA_US 100000   // Espera depois de um erro que fecha a conexão (503), como um navegador
+
+typedef enum {
+    ERRO_CONEXAO,   // connect() recusado, ou a conexão fechou antes de qualquer resposta
+    ERRO_RESET,     // A conexão caiu no meio da resposta
+    ERRO_TEMPO,     // Sem resposta em CARGA_TIMEOUT_S
+    ERRO_STATUS,    // Resposta com status 4xx ou 5xx (503: fila de comandos cheia)
+    ERRO_TIPOS,
+} erro_t;
+
+static const char *const nomes_erros[ERRO_TIPOS] = { "conexao", "reset", "tempo", "status" };
+
+typedef struct {
+    uint32_t *latencias;   // µs, uma por requisição respondida
+    size_t quantidade, capacidade;
+    uint32_t erros[ERRO_TIPOS];
+} amostras_t;
+
+typedef struct {
+    int id;
+    amostras_t rotas[CARGA_ROTAS_MAX];
+} trabalhador_t;
+
+static struct sockaddr_in servidor;
+static const char *rotas[CARGA_ROTAS_MAX];
+static int num_rotas;
+static int conexoes = 10;
+static int duracao_s = 5;
+static bool fecha_sempre;
+static bool saida_json;
+static uint64_t fim_us;
+
+static uint64_t agora_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static void registra(amostras_t *a, uint32_t latencia) {
+    if (a->quantidade == a->capacidade) {
+        a->capacidade = a->capacidade ? 2 * a->capacidade : 1024;
+        a->latencias = realloc(a->latencias, a->capacidade * sizeof(uint32_t));
+    }
+    a->latencias[a->quantidade++] = latencia;
+}
+
+static int conecta(void) {
+    struct timeval tempo = { .tv_sec = CARGA_TIMEOUT_S };
+    int um = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0) return -1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tempo, sizeof(tempo));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tempo, sizeof(tempo));
+    if (connect(fd, (struct sockaddr *)&servidor, sizeof(servidor)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static erro_t erro_de_recv(ssize_t n, size_t lidos) {
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return ERRO_TEMPO;
+    return lidos == 0 ? ERRO_CONEXAO : ERRO_RESET;
+}
+
+// Envia a requisição e lê a resposta inteira; retorna -1 se deu certo (com *fechar indicando se
+// o servidor vai fechar a conexão), ou o tipo do erro
+static int requisita(int fd, const char *caminho, bool *fechar) {
+    char buf[CARGA_CABECALHO_MAX];
+    int tam = snprintf(buf, sizeof(buf), "GET %s HTTP/1.1\r\nHost: robovigia\r\n%s\r\n", caminho,
+                       fecha_sempre ? "Connection: close\r\n" : "");
+    size_t lidos = 0;
+    ssize_t n;
+    char *fim;
+
+    if (send(fd, buf, tam, MSG_NOSIGNAL) != tam) return ERRO_CONEXAO;
+
+    // Cabeçalho
+    while (true) {
+        n = recv(fd, buf + lidos, sizeof(buf) - 1 - lidos, 0);
+        if (n <= 0) return erro_de_recv(n, lidos);
+        lidos += n;
+        buf[lidos] = '\0';
+        if ((fim = strstr(buf, "\r\n\r\n"))) break;
+        if (lidos == sizeof(buf) - 1) return ERRO_RESET;
+    }
+
+    int status = strncmp(buf, "HTTP/1.", 7) == 0 ? atoi(buf + 9) : 0;
+    const char *cl = strcasestr(buf, "\r\nContent-Length:");
+    long corpo = cl ? strtol(cl + 17, NULL, 10) : -1;
+    long resto = (long)(buf + lidos - (fim + 4));
+    *fechar = fecha_sempre || corpo < 0 || strcasestr(buf, "\r\nConnection: close") != NULL;
+
+    // Corpo: até o Content-Length, ou até o fim da conexão sem ele
+    while (corpo < 0 || resto < corpo) {
+        n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0 && corpo < 0) break;
+        if (n <= 0) return erro_de_recv(n, 1);
+        resto += n;
+    }
+
+    if (status < 200 || status >= 400) return ERRO_STATUS;
+    return -1;
+}
+
+static void *trabalhador_laco(void *arg) {
+    trabalhador_t *t = arg;
+    int fd = -1;
+    uint32_t k = t->id;
+
+    while (agora_us() < fim_us) {
+        amostras_t *a = &t->rotas[k % num_rotas];
+        const char *caminho = rotas[k++ % num_rotas];
+        uint64_t inicio = agora_us();
+        bool reaproveitada = fd >= 0, fechar = true;
+        int r;
+
+        if (fd < 0 && (fd = conecta()) < 0) {
+            a->erros[ERRO_CONEXAO]++;
+            usleep(1000);
+            continue;
+        }
+        r = requisita(fd, caminho, &fechar);
+
+        // Conexão keep-alive que o servidor fechou enquanto estava ociosa: tenta de novo numa
+        // nova, como um navegador faria
+        if (r == ERRO_CONEXAO && reaproveitada) {
+            close(fd);
+            inicio = agora_us();
+            if ((fd = conecta()) < 0) {
+                a->erros[ERRO_CONEXAO]++;
+                continue;
+            }
+            r = requisita(fd, caminho, &fechar);
+        }
+
+        if (r < 0) registra(a, (uint32_t)(agora_us() - inicio));
+        else a->erros[r]++;
+
+        if (r >= 0 && r != ERRO_STATUS) fechar = true;
+        if (fechar) {
+            close(fd);
+            fd = -1;
+        }
+
+        // Recusada por falta de slot (ou fila de comandos cheia): tentar de novo na hora só
+        // ocuparia o PCB de outra recusa
+        if (r == ERRO_STATUS && fechar) usleep(CARGA_RECUSA_US);
+    }
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+static int compara_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentil(const amostras_t *a, int p) {
+    if (a->quantidade == 0) return 0;
+    return a->latencias[(a->quantidade - 1) * p / 100];
+}
+
+// Junta as amostras de todas as threads para cada rota e imprime o resultado
+static void relata(trabalhador_t *ts, double segundos) {
+    if (!saida_json) {
+        printf("%d conexões, %.1f s, %s\n", conexoes, segundos, fecha_sempre ? "uma conexão por requisição" : "keep-alive");
+        printf("%-24s %9s %9s %9s %9s %9s %8s  %s\n", "rota", "req", "req/s", "p50 us", "p99 us", "max us",
+               "erros %", "erros");
+    }
+
+    for (int r = 0; r < num_rotas; r++) {
+        amostras_t total = { 0 };
+        for (int i = 0; i < conexoes; i++) {
+            amostras_t *a = &ts[i].rotas[r];
+            for (size_t j = 0; j < a->quantidade; j++) registra(&total, a->latencias[j]);
+            for (int e = 0; e < ERRO_TIPOS; e++) total.erros[e] += a->erros[e];
+        }
+        if (total.quantidade) qsort(total.latencias, total.quantidade, sizeof(uint32_t), compara_u32);
+
+        uint32_t erros = 0;
+        for (int e = 0; e < ERRO_TIPOS; e++) erros += total.erros[e];
+        size_t tentativas = total.quantidade + erros;
+        double taxa_erros = tentativas ? 100.0 * erros / tentativas : 0.0;
+        uint32_t max = total.quantidade ? total.latencias[total.quantidade - 1] : 0;
+
+        if (saida_json) {
+            printf("{\"rota\":\"%s\",\"conexoes\":%d,\"keep_alive\":%s,\"segundos\":%.1f,\"req\":%zu,"
+                   "\"req_s\":%.1f,\"p50_us\":%u,\"p99_us\":%u,\"max_us\":%u",
+                   rotas[r], conexoes, fecha_sempre ? "false" : "true", segundos, total.quantidade,
+                   total.quantidade / segundos, percentil(&total, 50), percentil(&total, 99), max);
+            for (int e = 0; e < ERRO_TIPOS; e++) printf(",\"erros_%s\":%u", nomes_erros[e], total.erros[e]);
+            printf("}\n");
+        } else {
+            printf("%-24s %9zu %9.1f %9u %9u %9u %8.2f ", rotas[r], total.quantidade, total.quantidade / segundos,
+                   percentil(&total, 50), percentil(&total, 99), max, taxa_erros);
+            for (int e = 0; e < ERRO_TIPOS; e++) {
+                if (total.erros[e]) printf(" %s=%u", nomes_erros[e], total.erros[e]);
+            }
+            printf("\n");
+        }
+        free(total.latencias);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *ip = "127.0.0.1";
+    int porta = 80;
+    int opcao;
+
+    while ((opcao = getopt(argc, argv, "h:p:c:d:fr:j")) != -1) {
+        switch (opcao) {
+            case 'h': ip = optarg; break;
+            case 'p': porta = atoi(optarg); break;
+            case 'c': conexoes = atoi(optarg); break;
+            case 'd': duracao_s = atoi(optarg); break;
+            case 'f': fecha_sempre = true; break;
+            case 'r':
+                if (num_rotas < CARGA_ROTAS_MAX) rotas[num_rotas++] = optarg;
+                break;
+            case 'j': saida_json = true; break;
+            default:
+                fprintf(stderr, "uso: %s [-h IP] [-p PORTA] [-c CONEXOES] [-d SEGUNDOS] [-f] [-r CAMINHO]... [-j]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (conexoes < 1 || conexoes > CARGA_CONEXOES_MAX || duracao_s < 1) {
+        fprintf(stderr, "carga: use de 1 a %d conexões e pelo menos 1 s\n", CARGA_CONEXOES_MAX);
+        return 2;
+    }
+    if (num_rotas == 0) {
+        rotas[num_rotas++] = "/";
+        rotas[num_rotas++] = "/cmd?seq=R";
+        rotas[num_rotas++] = "/cmd?seq=L";
+    }
+
+    servidor.sin_family = AF_INET;
+    servidor.sin_port = htons(porta);
+    if (inet_pton(AF_INET, ip, &servidor.sin_addr) != 1) {
+        fprintf(stderr, "carga: endereço inválido: %s\n", ip);
+        return 2;
+    }
+
+    trabalhador_t *ts = calloc(conexoes, sizeof(trabalhador_t));
+    pthread_t *threads = calloc(conexoes, sizeof(pthread_t));
+    uint64_t inicio = agora_us();
+    fim_us = inicio + (uint64_t)duracao_s * 1000000u;
+
+    for (int i = 0; i < conexoes; i++) {
+        ts[i].id = i;
+        pthread_create(&threads[i], NULL, trabalhador_laco, &ts[i]);
+    }
+    for (int i = 0; i < conexoes; i++) pthread_join(threads[i], NULL);
+
+    relata(ts, (agora_us() - inicio) / 1e6);
+
+    for (int i = 0; i < conexoes; i++) {
+        for (int r = 0; r < num_rotas; r++) free(ts[i].rotas[r].latencias);
+    }
+    free(ts);
+    free(threads);
+    return 0;
+}
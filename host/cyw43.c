@@ -0,0 +1,161 @@
+// Implementação no host do pico/cyw43_arch.h e do contexto assíncrono: o Wi-Fi conecta na hora,
+// o lock do lwIP é um mutex recursivo, e cyw43_arch_wait_for_work_until() dorme até o prazo, até
+// um trabalho pendente ou até um evento de rede, como o __wfe() da placa.
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/netif.h"
+#include "host/rede.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct async_context {
+    async_when_pending_worker_t *trabalhos;
+};
+
+static async_context_t contexto;
+static pthread_mutex_t contexto_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t contexto_cond;
+static bool contexto_evento;   // Trabalho pendente ou evento de rede desde a última espera
+static bool encerrar;
+static int codigo_saida;
+
+static pthread_mutex_t lwip_mutex;
+static pthread_once_t locks_once = PTHREAD_ONCE_INIT;
+
+static void locks_inicia(void) {
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&lwip_mutex, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&contexto_cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+}
+
+pthread_mutex_t *host_lwip_lock(void) {
+    pthread_once(&locks_once, locks_inicia);
+    return &lwip_mutex;
+}
+
+void cyw43_arch_lwip_begin(void) {
+    pthread_mutex_lock(host_lwip_lock());
+}
+
+void cyw43_arch_lwip_end(void) {
+    pthread_mutex_unlock(host_lwip_lock());
+}
+
+void host_contexto_acorda(void) {
+    pthread_once(&locks_once, locks_inicia);
+    pthread_mutex_lock(&contexto_mutex);
+    contexto_evento = true;
+    pthread_cond_signal(&contexto_cond);
+    pthread_mutex_unlock(&contexto_mutex);
+}
+
+void host_encerra(int codigo) {
+    pthread_once(&locks_once, locks_inicia);
+    pthread_mutex_lock(&contexto_mutex);
+    encerrar = true;
+    codigo_saida = codigo;
+    pthread_cond_signal(&contexto_cond);
+    pthread_mutex_unlock(&contexto_mutex);
+}
+
+async_context_t *cyw43_arch_async_context(void) {
+    return &contexto;
+}
+
+bool async_context_add_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker) {
+    pthread_mutex_lock(&contexto_mutex);
+    worker->next = context->trabalhos;
+    context->trabalhos = worker;
+    pthread_mutex_unlock(&contexto_mutex);
+    return true;
+}
+
+void async_context_set_work_pending(async_context_t *context, async_when_pending_worker_t *worker) {
+    (void)context;
+    pthread_mutex_lock(&contexto_mutex);
+    worker->work_pending = true;
+    pthread_mutex_unlock(&contexto_mutex);
+    host_contexto_acorda();
+}
+
+// Os trabalhos pendentes rodam com o lock do lwIP, como no contexto assíncrono da placa
+void cyw43_arch_poll(void) {
+    cyw43_arch_lwip_begin();
+    for (async_when_pending_worker_t *w = contexto.trabalhos; w; w = w->next) {
+        pthread_mutex_lock(&contexto_mutex);
+        bool pendente = w->work_pending;
+        w->work_pending = false;
+        pthread_mutex_unlock(&contexto_mutex);
+        if (pendente) w->do_work(&contexto, w);
+    }
+    cyw43_arch_lwip_end();
+}
+
+void cyw43_arch_wait_for_work_until(absolute_time_t until) {
+    pthread_once(&locks_once, locks_inicia);
+
+    int64_t falta_us = absolute_time_diff_us(get_absolute_time(), until);
+    struct timespec prazo;
+    if (falta_us < 0) falta_us = 0;
+    clock_gettime(CLOCK_MONOTONIC, &prazo);
+    prazo.tv_sec += falta_us / 1000000;
+    prazo.tv_nsec += (falta_us % 1000000) * 1000;
+    if (prazo.tv_nsec >= 1000000000) {
+        prazo.tv_sec++;
+        prazo.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&contexto_mutex);
+    while (!contexto_evento && !encerrar) {
+        if (pthread_cond_timedwait(&contexto_cond, &contexto_mutex, &prazo) == ETIMEDOUT) break;
+    }
+    contexto_evento = false;
+    bool sair = encerrar;
+    pthread_mutex_unlock(&contexto_mutex);
+
+    if (sair) {
+        fflush(stdout);
+        exit(codigo_saida);
+    }
+    cyw43_arch_poll();
+}
+
+//====================================
+//      Wi-Fi
+//====================================
+
+static struct netif interface = { .ip_addr = { .addr = 0x0100007f } };   // 127.0.0.1
+struct netif *netif_default;
+
+int cyw43_arch_init(void) {
+    pthread_once(&locks_once, locks_inicia);
+    host_rede_inicia();
+    return 0;
+}
+
+void cyw43_arch_deinit(void) {
+}
+
+void cyw43_arch_enable_sta_mode(void) {
+}
+
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *pw, uint32_t auth, uint32_t timeout) {
+    (void)ssid; (void)pw; (void)auth; (void)timeout;
+    netif_default = &interface;
+    return 0;
+}
+
+void cyw43_arch_gpio_put(uint wl_gpio, bool value) {
+    (void)wl_gpio; (void)value;
+}
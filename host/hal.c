@@ -0,0 +1,383 @@
+// Implementação no host das funções de hardware usadas pelo firmware.
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "pico/bootrom.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/i2c.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "host/hal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_GPIOS 30
+#define HOST_SPIN_LOCKS 32
+#define HOST_IRQS 32
+#define HOST_IRQ_HANDLERS 4
+
+static i2c_hw_t i2c0_hw = { .status = I2C_IC_STATUS_TFE_BITS };
+static i2c_hw_t i2c1_hw = { .status = I2C_IC_STATUS_TFE_BITS };
+i2c_inst_t i2c0_inst = { .hw = &i2c0_hw };
+i2c_inst_t i2c1_inst = { .hw = &i2c1_hw };
+
+// Canais de DMA: só guardam a configuração; a cópia é feita na hora do disparo
+#define HOST_DMA_CHANNELS 12
+
+static struct {
+    bool claimed;
+    dma_channel_config config;
+    volatile void *write_addr;
+    bool irq0_enabled;
+    volatile bool irq0_status;
+} dma_channels[HOST_DMA_CHANNELS];
+
+static bool gpio_nivel[HOST_GPIOS];
+static gpio_irq_callback_t gpio_callback;
+static uint16_t pwm_nivel[HOST_GPIOS];
+
+static spin_lock_t spin_locks[HOST_SPIN_LOCKS];
+static uint32_t spin_locks_claimed;
+
+static struct {
+    irq_handler_t handlers[HOST_IRQ_HANDLERS];
+    uint handlers_tam;
+    bool enabled;
+} irqs[HOST_IRQS];
+
+pio_hw_t pio0_hw, pio1_hw;
+static uint pio_sms_claimed[2];
+
+// Fita de LEDs: cada transferência para uma FIFO de PIO reescreve os primeiros pixels, e os
+// seguintes mantêm a cor anterior, como na fita de verdade
+static uint32_t ws2812b_pixels[HOST_WS2812B_MAX];
+static uint ws2812b_tam;
+static uint32_t ws2812b_quadros;
+static spin_lock_t ws2812b_lock;
+
+// O stdout sai linha a linha, como pela UART
+bool stdio_init_all(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return true;
+}
+
+// Console: texto entregue pela simulação, lido um caractere por vez pelo firmware
+#define HOST_CONSOLE_TAM 64
+
+static char console[HOST_CONSOLE_TAM];
+static uint console_inicio, console_tam;
+static spin_lock_t console_lock;
+
+void host_console_envia(const char *texto) {
+    spin_lock_blocking(&console_lock);
+    for (; *texto && console_tam < HOST_CONSOLE_TAM; texto++) {
+        console[(console_inicio + console_tam++) % HOST_CONSOLE_TAM] = *texto;
+    }
+    spin_unlock(&console_lock, 0);
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    (void)timeout_us;   // Só é chamada sem espera
+    int c = PICO_ERROR_TIMEOUT;
+    spin_lock_blocking(&console_lock);
+    if (console_tam) {
+        c = (unsigned char)console[console_inicio];
+        console_inicio = (console_inicio + 1) % HOST_CONSOLE_TAM;
+        console_tam--;
+    }
+    spin_unlock(&console_lock, 0);
+    return c;
+}
+
+// USB (CDC): cada escrita vai inteira para o arquivo, como um pacote
+static FILE *usb_arquivo;
+static spin_lock_t usb_lock;
+
+static void usb_out_chars(const char *buf, int len) {
+    spin_lock_blocking(&usb_lock);
+    if (usb_arquivo) {
+        fwrite(buf, 1, len, usb_arquivo);
+        fflush(usb_arquivo);
+    }
+    spin_unlock(&usb_lock, 0);
+}
+
+stdio_driver_t stdio_usb = { .out_chars = usb_out_chars };
+
+void host_usb_conecta(FILE *arquivo) {
+    usb_arquivo = arquivo;
+}
+
+bool stdio_usb_connected(void) {
+    return usb_arquivo != NULL;
+}
+
+static _Thread_local uint nucleo_atual;
+
+void host_nucleo_define(uint nucleo) {
+    nucleo_atual = nucleo;
+}
+
+uint get_core_num(void) {
+    return nucleo_atual;
+}
+
+void gpio_init(uint gpio) {
+    gpio_nivel[gpio] = false;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    (void)gpio;
+    (void)out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    gpio_nivel[gpio] = value;
+}
+
+bool gpio_get(uint gpio) {
+    return gpio_nivel[gpio];
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_pull_up(uint gpio) {
+    gpio_nivel[gpio] = true;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    (void)gpio;
+    (void)event_mask;
+    (void)enabled;
+    gpio_callback = callback;
+}
+
+void host_gpio_evento(uint gpio, uint32_t eventos) {
+    if (gpio_callback) gpio_callback(gpio, eventos);
+}
+
+void adc_init(void) {}
+
+void adc_gpio_init(uint gpio) {
+    (void)gpio;
+}
+
+void adc_select_input(uint input) {
+    (void)input;
+}
+
+uint16_t adc_read(void) {
+    return 2048;   // Joystick centralizado
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return clk_index == clk_usb || clk_index == clk_adc ? 48000000 : 125000000;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start) {
+    (void)slice_num;
+    (void)c;
+    (void)start;
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap) {
+    (void)slice_num;
+    (void)wrap;
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+    pwm_nivel[gpio] = level;
+}
+
+uint16_t host_pwm_nivel(uint gpio) {
+    return pwm_nivel[gpio];
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void)pio;
+    (void)program;
+    return 0;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    uint *claimed = &pio_sms_claimed[pio == pio0 ? 0 : 1];
+    for (int sm = 0; sm < 4; sm++) {
+        if (!(*claimed & (1u << sm))) {
+            *claimed |= 1u << sm;
+            return sm;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "host: sem máquinas PIO livres\n");
+        abort();
+    }
+    return -1;
+}
+
+int spin_lock_claim_unused(bool required) {
+    for (int i = 0; i < HOST_SPIN_LOCKS; i++) {
+        if (!(spin_locks_claimed & (1u << i))) {
+            spin_locks_claimed |= 1u << i;
+            atomic_flag_clear(&spin_locks[i]);
+            return i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "host: sem spin locks livres\n");
+        abort();
+    }
+    return -1;
+}
+
+spin_lock_t *spin_lock_instance(uint lock_num) {
+    return &spin_locks[lock_num];
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    if (irqs[num].handlers_tam < HOST_IRQ_HANDLERS) irqs[num].handlers[irqs[num].handlers_tam++] = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    irqs[num].enabled = enabled;
+}
+
+// Interrupção de fim de DMA: entregue pela thread dos alarmes, como a interrupção do hardware,
+// que nunca interrompe quem está com um spin lock (no RP2040 o spin lock desabilita interrupções)
+static int64_t dma_irq0(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    if (irqs[DMA_IRQ_0].enabled) {
+        for (uint i = 0; i < irqs[DMA_IRQ_0].handlers_tam; i++) irqs[DMA_IRQ_0].handlers[i]();
+    }
+    return 0;
+}
+
+void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask, uint32_t disable_interface_mask) {
+    (void)usb_activity_gpio_pin_mask;
+    (void)disable_interface_mask;
+    printf("host: reset_usb_boot() encerra a simulação\n");
+    exit(0);
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)addr;
+    (void)src;
+    (void)nostop;
+    i2c->bytes += len + 1;
+    i2c->transactions++;
+    return (int)len;
+}
+
+int dma_claim_unused_channel(bool required) {
+    (void)required;
+    for (int i = 0; i < HOST_DMA_CHANNELS; i++) {
+        if (!dma_channels[i].claimed) {
+            dma_channels[i].claimed = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    return (dma_channel_config){ .size = DMA_SIZE_32, .read_increment = true };
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    dma_channels[channel].config = *config;
+    dma_channels[channel].write_addr = write_addr;
+    if (trigger) dma_channel_transfer_from_buffer_now(channel, read_addr, transfer_count);
+}
+
+// Escritas na FIFO de TX de uma PIO viram pixels da fita de LEDs
+static bool dma_to_pio(volatile void *addr, uint32_t word, uint32_t i) {
+    if ((volatile uint8_t *)addr < (volatile uint8_t *)pio0_hw.txf ||
+        (volatile uint8_t *)addr >= (volatile uint8_t *)(pio1_hw.txf + 4)) {
+        return false;
+    }
+    if (i < HOST_WS2812B_MAX) ws2812b_pixels[i] = word;
+    return true;
+}
+
+// Escritas no DATA_CMD de um I2C viram bytes no barramento (uma transação a cada STOP)
+static bool dma_to_i2c(volatile void *addr, i2c_inst_t *i2c, uint32_t word) {
+    if (addr != &i2c->hw->data_cmd) return false;
+    i2c->bytes++;
+    if (word & I2C_IC_DATA_CMD_STOP_BITS) {
+        i2c->bytes++;                 // Byte de endereço da transação
+        i2c->transactions++;
+    }
+    return true;
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+    const dma_channel_config *c = &dma_channels[channel].config;
+    const volatile uint8_t *src = read_addr;
+    uint32_t size = 1u << c->size;
+
+    volatile void *dst = dma_channels[channel].write_addr;
+    bool pio = dma_to_pio(dst, 0, HOST_WS2812B_MAX);
+
+    if (pio) spin_lock_blocking(&ws2812b_lock);
+    for (uint32_t i = 0; i < transfer_count; i++) {
+        uint32_t word = 0;
+        memcpy(&word, (const void *)src, size);
+        if (!dma_to_pio(dst, word, i) && !dma_to_i2c(dst, i2c0, word) && !dma_to_i2c(dst, i2c1, word)) {
+            memcpy((void *)dst, &word, size);
+        }
+        if (c->read_increment) src += size;
+    }
+    if (pio) {
+        uint tam = transfer_count < HOST_WS2812B_MAX ? transfer_count : HOST_WS2812B_MAX;
+        if (tam > ws2812b_tam) ws2812b_tam = tam;
+        ws2812b_quadros++;
+        spin_unlock(&ws2812b_lock, 0);
+    }
+
+    if (dma_channels[channel].irq0_enabled) {
+        dma_channels[channel].irq0_status = true;
+        add_alarm_in_us(0, dma_irq0, NULL, true);
+    }
+}
+
+uint host_ws2812b_quadro(uint32_t *pixels, uint max, uint32_t *quadros) {
+    spin_lock_blocking(&ws2812b_lock);
+    uint tam = ws2812b_tam < max ? ws2812b_tam : max;
+    memcpy(pixels, ws2812b_pixels, tam * sizeof(uint32_t));
+    *quadros = ws2812b_quadros;
+    spin_unlock(&ws2812b_lock, 0);
+    return tam;
+}
+
+bool dma_channel_is_busy(uint channel) {
+    (void)channel;
+    return false;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    dma_channels[channel].irq0_enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel) {
+    return dma_channels[channel].irq0_status;
+}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+    dma_channels[channel].irq0_status = false;
+}
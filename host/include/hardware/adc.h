@@ -0,0 +1,12 @@
+// Substituto do hardware/adc.h: as leituras retornam o centro da escala (joystick parado).
+#ifndef HOST_HARDWARE_ADC_H
+#define HOST_HARDWARE_ADC_H
+
+#include "pico/stdlib.h"
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+uint16_t adc_read(void);
+
+#endif // HOST_HARDWARE_ADC_H
@@ -0,0 +1,44 @@
+// Substituto do hardware/i2c.h: as escritas só são contadas (bytes e transações).
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+#include "pico/stdlib.h"
+
+// Registradores usados pelos drivers (subconjunto do bloco I2C do RP2040)
+typedef struct {
+    volatile uint32_t tar;
+    volatile uint32_t data_cmd;
+    volatile uint32_t status;
+    volatile uint32_t enable;
+    volatile uint32_t clr_tx_abrt;
+} i2c_hw_t;
+
+typedef struct i2c_inst {
+    i2c_hw_t *hw;
+    bool restart_on_next;
+    uint32_t baudrate;
+    uint32_t bytes;          // Bytes escritos, incluindo o de endereço
+    uint32_t transactions;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst, i2c1_inst;
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+#define I2C_IC_DATA_CMD_STOP_BITS       0x00000200u
+#define I2C_IC_DATA_CMD_RESTART_BITS    0x00000400u
+#define I2C_IC_STATUS_TFE_BITS          0x00000004u
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS 0x00000020u
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+
+static inline i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) {
+    return i2c->hw;
+}
+
+static inline uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) {
+    return (i2c == i2c0 ? 32 : 34) + (is_tx ? 0 : 1);
+}
+
+#endif // HOST_HARDWARE_I2C_H
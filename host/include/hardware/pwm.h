@@ -0,0 +1,28 @@
+// Substituto do hardware/pwm.h: guarda o wrap de cada slice e o nível de cada pino.
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    float clkdiv;
+    uint16_t top;
+} pwm_config;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1) & 7;
+}
+
+static inline pwm_config pwm_get_default_config(void) {
+    return (pwm_config){ .clkdiv = 1.0f, .top = 0xffff };
+}
+
+static inline void pwm_config_set_clkdiv(pwm_config *c, float div) {
+    c->clkdiv = div;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start);
+void pwm_set_wrap(uint slice_num, uint16_t wrap);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+
+#endif // HOST_HARDWARE_PWM_H
@@ -0,0 +1,42 @@
+// Substituto do hardware/sync.h: os spin locks são flags atômicas (os núcleos são threads) e as
+// barreiras de memória viram barreiras do compilador e do processador do computador.
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include <stdatomic.h>
+
+#include "pico/stdlib.h"
+
+typedef atomic_flag spin_lock_t;
+
+static inline void __dmb(void) {
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+static inline void __sev(void) {}
+static inline void __wfe(void) {}
+
+// Não há interrupções a desabilitar: os contextos de interrupção do host são threads, e o que
+// elas compartilham com o resto do firmware é protegido por spin locks ou pelo lock do lwIP
+static inline uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+int spin_lock_claim_unused(bool required);
+spin_lock_t *spin_lock_instance(uint lock_num);
+
+static inline uint32_t spin_lock_blocking(spin_lock_t *lock) {
+    while (atomic_flag_test_and_set_explicit(lock, memory_order_acquire)) tight_loop_contents();
+    return 0;
+}
+
+static inline void spin_unlock(spin_lock_t *lock, uint32_t saved_irq) {
+    (void)saved_irq;
+    atomic_flag_clear_explicit(lock, memory_order_release);
+}
+
+#endif // HOST_HARDWARE_SYNC_H
@@ -0,0 +1,13 @@
+// Substituto do hardware/timer.h: contador de us desde o início do programa.
+#ifndef HOST_HARDWARE_TIMER_H
+#define HOST_HARDWARE_TIMER_H
+
+#include <stdint.h>
+
+uint64_t time_us_64(void);
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+#endif // HOST_HARDWARE_TIMER_H
@@ -0,0 +1,32 @@
+// Consulta, no host, do que o firmware fez com o hardware simulado (para o driver da simulação
+// e para os benchmarks).
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+#define HOST_WS2812B_MAX 64   // Pixels guardados da fita de LEDs
+
+// Estado da fita de LEDs alimentada por DMA pela FIFO de uma máquina PIO (palavras GRB << 8, como
+// o firmware escreve) e total de quadros enviados; retorna quantos pixels já foram escritos
+uint host_ws2812b_quadro(uint32_t *pixels, uint max, uint32_t *quadros);
+
+// Nível do PWM de um pino (0 = desligado)
+uint16_t host_pwm_nivel(uint gpio);
+
+// Simula um evento (por exemplo, GPIO_IRQ_EDGE_FALL de um botão) chamando o tratador registrado
+void host_gpio_evento(uint gpio, uint32_t eventos);
+
+// Entrega texto ao console do firmware (lido por getchar_timeout_us)
+void host_console_envia(const char *texto);
+
+// Liga a USB (CDC) ao arquivo: o que o firmware escreve em stdio_usb vai para ele
+void host_usb_conecta(FILE *arquivo);
+
+// Marca a thread que chama como a do núcleo dado (para get_core_num)
+void host_nucleo_define(uint nucleo);
+
+#endif // HOST_HAL_H
@@ -0,0 +1,59 @@
+// Lado do cliente da pilha TCP em memória do host (host/rede.c) e controle da simulação. Cada
+// conexão é aberta contra uma porta em que o firmware chamou tcp_listen(); os dados passam pelos
+// mesmos callbacks do lwIP (accept, recv, sent, poll, err), com as mesmas janelas e limites do
+// lwipopts.h. As funções podem ser chamadas de qualquer thread: elas tomam o lock do lwIP, como
+// a interrupção do cyw43 faz na placa.
+#ifndef HOST_REDE_H
+#define HOST_REDE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pthread.h>
+
+typedef struct host_cliente host_cliente_t;
+
+// Abre uma conexão com a porta; retorna NULL se ninguém escuta nela ou se não há PCB livre
+host_cliente_t *host_rede_conecta(uint16_t porta);
+
+// Envia até tam bytes ao firmware; retorna quantos couberam na janela TCP e nos pbufs livres
+// (0 se nenhum), ou -1 se a conexão foi resetada
+int host_rede_envia(host_cliente_t *c, const void *dados, size_t tam);
+
+// Lê (e confirma, o que chama o callback sent) até max bytes enviados pelo firmware; retorna
+// quantos foram lidos, ou -1 se a conexão foi resetada
+int host_rede_recebe(host_cliente_t *c, void *buf, size_t max);
+
+// O firmware fechou o seu lado e tudo o que ele enviou já foi lido
+bool host_rede_fechada(host_cliente_t *c);
+
+// Espera até haver algo para ler, o fim ou um reset na conexão, por no máximo timeout_us;
+// retorna false se o tempo acabou
+bool host_rede_espera(host_cliente_t *c, uint64_t timeout_us);
+
+// Fecha a conexão (FIN) e libera o cliente; o que o firmware ainda enviar é confirmado sozinho
+void host_rede_fecha(host_cliente_t *c);
+
+// Reseta a conexão (RST) e libera o cliente
+void host_rede_reseta(host_cliente_t *c);
+
+// Há alguém escutando na porta (o firmware já chegou ao tcp_listen())
+bool host_rede_escutando(uint16_t porta);
+
+// Escuta em 127.0.0.1:porta_local e liga cada conexão aceita a uma conexão com a porta do
+// firmware (host/ponte.c); retorna false se não foi possível escutar
+bool host_ponte_inicia(uint16_t porta_local, uint16_t porta);
+
+// Faz o loop principal do firmware terminar o processo com o código dado na próxima vez que
+// ele esperar por trabalho em cyw43_arch_wait_for_work_until()
+void host_encerra(int codigo);
+
+// Uso interno dos substitutos: o lock do lwIP (recursivo) e o aviso ao loop principal de que
+// chegou um evento de rede, como a interrupção do cyw43 o acordaria; host_rede_inicia() é
+// chamada por cyw43_arch_init() e dispara a thread dos temporizadores do TCP
+pthread_mutex_t *host_lwip_lock(void);
+void host_contexto_acorda(void);
+void host_rede_inicia(void);
+
+#endif // HOST_REDE_H
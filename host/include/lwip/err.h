@@ -0,0 +1,19 @@
+// Substituto do lwip/err.h: códigos de erro do lwIP.
+#ifndef HOST_LWIP_ERR_H
+#define HOST_LWIP_ERR_H
+
+#include "lwip/arch.h"
+
+typedef s8_t err_t;
+
+#define ERR_OK    0
+#define ERR_MEM  -1
+#define ERR_BUF  -2
+#define ERR_VAL  -6
+#define ERR_USE  -8
+#define ERR_CONN -11
+#define ERR_ABRT -13
+#define ERR_RST  -14
+#define ERR_CLSD -15
+
+#endif // HOST_LWIP_ERR_H
@@ -0,0 +1,16 @@
+// Substituto do lwip/ip_addr.h: apenas IPv4.
+#ifndef HOST_LWIP_IP_ADDR_H
+#define HOST_LWIP_IP_ADDR_H
+
+#include "lwip/arch.h"
+
+typedef struct {
+    u32_t addr;   // Ordem de rede
+} ip_addr_t;
+
+extern const ip_addr_t ip_addr_any;
+#define IP_ADDR_ANY (&ip_addr_any)
+
+char *ipaddr_ntoa(const ip_addr_t *addr);
+
+#endif // HOST_LWIP_IP_ADDR_H
@@ -0,0 +1,13 @@
+// Substituto do lwip/netif.h: uma única interface, com o endereço de loopback.
+#ifndef HOST_LWIP_NETIF_H
+#define HOST_LWIP_NETIF_H
+
+#include "lwip/ip_addr.h"
+
+struct netif {
+    ip_addr_t ip_addr;
+};
+
+extern struct netif *netif_default;
+
+#endif // HOST_LWIP_NETIF_H
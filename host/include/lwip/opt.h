@@ -0,0 +1,8 @@
+// Substituto do lwip/opt.h: usa os limites do lwipopts.h do firmware, para que a pilha em memória
+// de host/rede.c tenha os mesmos buffers, filas e quantidade de PCBs da placa.
+#ifndef HOST_LWIP_OPT_H
+#define HOST_LWIP_OPT_H
+
+#include "lwipopts.h"
+
+#endif // HOST_LWIP_OPT_H
@@ -0,0 +1,25 @@
+// Substituto do lwip/pbuf.h: pbufs de um pool com PBUF_POOL_SIZE entradas de até TCP_MSS bytes,
+// como os que o driver do cyw43 entrega ao lwIP.
+#ifndef HOST_LWIP_PBUF_H
+#define HOST_LWIP_PBUF_H
+
+#include "lwip/opt.h"
+#include "lwip/arch.h"
+#include "lwip/err.h"
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+    u8_t ref;
+    u8_t dados[TCP_MSS];
+};
+
+u8_t pbuf_free(struct pbuf *p);
+void pbuf_cat(struct pbuf *head, struct pbuf *tail);
+u16_t pbuf_clen(const struct pbuf *p);
+struct pbuf *pbuf_free_header(struct pbuf *q, u16_t size);
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset);
+
+#endif // HOST_LWIP_PBUF_H
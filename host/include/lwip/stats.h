@@ -0,0 +1,55 @@
+// Substituto do lwip/stats.h: só os contadores que o firmware lê (MEM_STATS, MEMP_STATS e
+// LINK_STATS), com os nomes e campos do lwIP 2.1. São mantidos pela pilha em memória de
+// host/rede.c: os pools de PCBs, de pbufs e de segmentos seguem as alocações dela, e o heap
+// conta os bytes das escritas com cópia ainda não confirmadas.
+#ifndef HOST_LWIP_STATS_H
+#define HOST_LWIP_STATS_H
+
+#include "lwip/opt.h"
+#include "lwip/arch.h"
+
+typedef u32_t STAT_COUNTER;   // LWIP_STATS_LARGE
+typedef u16_t mem_size_t;
+
+// Pools do memp usados pelo servidor (no lwIP, gerados de lwip/priv/memp_std.h)
+typedef enum {
+    MEMP_TCP_PCB,
+    MEMP_TCP_PCB_LISTEN,
+    MEMP_TCP_SEG,
+    MEMP_PBUF,
+    MEMP_PBUF_POOL,
+    MEMP_MAX
+} memp_t;
+
+struct stats_proto {
+    STAT_COUNTER xmit;
+    STAT_COUNTER recv;
+    STAT_COUNTER fw;
+    STAT_COUNTER drop;
+    STAT_COUNTER chkerr;
+    STAT_COUNTER lenerr;
+    STAT_COUNTER memerr;
+    STAT_COUNTER rterr;
+    STAT_COUNTER proterr;
+    STAT_COUNTER opterr;
+    STAT_COUNTER err;
+    STAT_COUNTER cachehit;
+};
+
+struct stats_mem {
+    STAT_COUNTER err;
+    mem_size_t avail;
+    mem_size_t used;
+    mem_size_t max;
+    STAT_COUNTER illegal;
+};
+
+struct stats_ {
+    struct stats_proto link;
+    struct stats_mem mem;
+    struct stats_mem *memp[MEMP_MAX];
+};
+
+extern struct stats_ lwip_stats;
+
+#endif // HOST_LWIP_STATS_H
@@ -0,0 +1,26 @@
+// Substituto do pico/cyw43_arch.h (modo threadsafe_background): a "conexão Wi-Fi" é imediata,
+// o lwIP é a pilha em memória de host/rede.c, e o lock do lwIP é um mutex recursivo que também
+// é tomado por quem entrega eventos de rede ao firmware (como a interrupção do cyw43 faz).
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+#include "pico/stdlib.h"
+#include "pico/async_context.h"
+
+#define CYW43_WL_GPIO_LED_PIN 0
+#define CYW43_AUTH_WPA2_AES_PSK 0x00400004
+
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
+void cyw43_arch_enable_sta_mode(void);
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *pw, uint32_t auth, uint32_t timeout);
+void cyw43_arch_gpio_put(uint wl_gpio, bool value);
+
+void cyw43_arch_lwip_begin(void);
+void cyw43_arch_lwip_end(void);
+
+async_context_t *cyw43_arch_async_context(void);
+void cyw43_arch_poll(void);
+void cyw43_arch_wait_for_work_until(absolute_time_t until);
+
+#endif // HOST_PICO_CYW43_ARCH_H
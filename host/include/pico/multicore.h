@@ -0,0 +1,17 @@
+// Substituto do pico/multicore.h: o núcleo 1 é uma thread, e a FIFO entre os núcleos (8
+// palavras em cada sentido, como no RP2040) é uma fila com mutex e variável de condição.
+#ifndef HOST_PICO_MULTICORE_H
+#define HOST_PICO_MULTICORE_H
+
+#include "pico/stdlib.h"
+
+void multicore_launch_core1(void (*entry)(void));
+void multicore_reset_core1(void);
+
+bool multicore_fifo_rvalid(void);
+bool multicore_fifo_wready(void);
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+bool multicore_fifo_pop_timeout_us(uint64_t timeout_us, uint32_t *out);
+
+#endif // HOST_PICO_MULTICORE_H
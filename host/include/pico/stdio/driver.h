@@ -0,0 +1,10 @@
+// Substituto do pico/stdio/driver.h: só a saída de um driver do stdio, usada para escrever
+// direto na USB sem passar pelos outros drivers nem pela tradução de '\n'.
+#ifndef HOST_PICO_STDIO_DRIVER_H
+#define HOST_PICO_STDIO_DRIVER_H
+
+typedef struct stdio_driver {
+    void (*out_chars)(const char *buf, int len);
+} stdio_driver_t;
+
+#endif // HOST_PICO_STDIO_DRIVER_H
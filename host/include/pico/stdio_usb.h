@@ -0,0 +1,13 @@
+// Substituto do pico/stdio_usb.h: a USB (CDC) da simulação é um arquivo, aberto com
+// host_usb_conecta() (host/hal.h); sem ele, a USB fica desconectada.
+#ifndef HOST_PICO_STDIO_USB_H
+#define HOST_PICO_STDIO_USB_H
+
+#include "pico/stdlib.h"
+#include "pico/stdio/driver.h"
+
+extern stdio_driver_t stdio_usb;
+
+bool stdio_usb_connected(void);
+
+#endif // HOST_PICO_STDIO_USB_H
@@ -0,0 +1,26 @@
+// Substituto mínimo do pico/stdlib.h para compilar partes do firmware no computador (host).
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+static inline void tight_loop_contents(void) {}
+
+#include "hardware/gpio.h"
+#include "pico/time.h"
+
+#define PICO_ERROR_TIMEOUT (-1)
+
+bool stdio_init_all(void);
+
+// Console: lê o que foi entregue por host_console_envia() (host/hal.h)
+int getchar_timeout_us(uint32_t timeout_us);
+
+// Núcleo da thread que chama: 1 na thread do núcleo 1, 0 nas outras (núcleo 0 e interrupções)
+uint get_core_num(void);
+
+#endif // HOST_PICO_STDLIB_H
@@ -0,0 +1,22 @@
+// Substituto do ws2812b.pio.h gerado pelo pioasm: o programa não é executado no host.
+#ifndef HOST_WS2812B_PIO_H
+#define HOST_WS2812B_PIO_H
+
+#include "hardware/pio.h"
+
+static const uint16_t ws2812b_program_instructions[8] = { 0 };
+
+static const pio_program_t ws2812b_program = {
+    .instructions = ws2812b_program_instructions,
+    .length = 8,
+    .origin = -1,
+};
+
+static inline void ws2812b_program_init(PIO pio, uint sm, uint offset, uint pin) {
+    (void)pio;
+    (void)sm;
+    (void)offset;
+    gpio_set_function(pin, GPIO_FUNC_PIO0);
+}
+
+#endif // HOST_WS2812B_PIO_H
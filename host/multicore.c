@@ -0,0 +1,132 @@
+// Implementação no host do pico/multicore.h: o núcleo 1 é uma thread, e cada sentido da FIFO
+// entre os núcleos tem 8 palavras, como no RP2040. O sentido é escolhido pela thread que chama.
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "host/hal.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define HOST_FIFO_TAM 8
+
+typedef struct {
+    uint32_t dados[HOST_FIFO_TAM];
+    uint inicio, quantidade;
+} fifo_t;
+
+static fifo_t para_core1, para_core0;
+static pthread_mutex_t fifo_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fifo_cond = PTHREAD_COND_INITIALIZER;   // Qualquer mudança numa das FIFOs
+
+static pthread_t core1;
+static bool core1_ativo;
+static void (*core1_entrada)(void);
+
+static inline bool no_core1(void) {
+    return core1_ativo && pthread_equal(pthread_self(), core1);
+}
+
+// FIFO em que este núcleo escreve e FIFO de que ele lê
+static inline fifo_t *fifo_escrita(void) {
+    return no_core1() ? &para_core0 : &para_core1;
+}
+
+static inline fifo_t *fifo_leitura(void) {
+    return no_core1() ? &para_core1 : &para_core0;
+}
+
+static void *core1_laco(void *arg) {
+    (void)arg;
+    host_nucleo_define(1);
+    core1_entrada();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    if (core1_ativo) {
+        fprintf(stderr, "host: núcleo 1 já está rodando\n");
+        abort();
+    }
+    core1_entrada = entry;
+    core1_ativo = true;
+    pthread_create(&core1, NULL, core1_laco, NULL);
+}
+
+void multicore_reset_core1(void) {
+    if (!core1_ativo) return;
+    pthread_cancel(core1);
+    pthread_join(core1, NULL);
+    core1_ativo = false;
+
+    pthread_mutex_lock(&fifo_mutex);
+    para_core1.quantidade = 0;
+    para_core0.quantidade = 0;
+    pthread_mutex_unlock(&fifo_mutex);
+}
+
+bool multicore_fifo_rvalid(void) {
+    pthread_mutex_lock(&fifo_mutex);
+    bool valido = fifo_leitura()->quantidade > 0;
+    pthread_mutex_unlock(&fifo_mutex);
+    return valido;
+}
+
+bool multicore_fifo_wready(void) {
+    pthread_mutex_lock(&fifo_mutex);
+    bool livre = fifo_escrita()->quantidade < HOST_FIFO_TAM;
+    pthread_mutex_unlock(&fifo_mutex);
+    return livre;
+}
+
+void multicore_fifo_push_blocking(uint32_t data) {
+    pthread_mutex_lock(&fifo_mutex);
+    fifo_t *f = fifo_escrita();
+    while (f->quantidade == HOST_FIFO_TAM) pthread_cond_wait(&fifo_cond, &fifo_mutex);
+    f->dados[(f->inicio + f->quantidade++) % HOST_FIFO_TAM] = data;
+    pthread_cond_broadcast(&fifo_cond);
+    pthread_mutex_unlock(&fifo_mutex);
+}
+
+// Retira uma palavra da FIFO de leitura; com timeout_us < 0 espera sem limite
+static bool fifo_retira(int64_t timeout_us, uint32_t *out) {
+    struct timespec prazo;
+    bool ok = true;
+
+    if (timeout_us >= 0) {
+        clock_gettime(CLOCK_REALTIME, &prazo);
+        prazo.tv_sec += timeout_us / 1000000;
+        prazo.tv_nsec += (timeout_us % 1000000) * 1000;
+        if (prazo.tv_nsec >= 1000000000) {
+            prazo.tv_sec++;
+            prazo.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&fifo_mutex);
+    fifo_t *f = fifo_leitura();
+    while (f->quantidade == 0 && ok) {
+        if (timeout_us < 0) pthread_cond_wait(&fifo_cond, &fifo_mutex);
+        else if (pthread_cond_timedwait(&fifo_cond, &fifo_mutex, &prazo) == ETIMEDOUT) ok = f->quantidade > 0;
+    }
+    if (ok) {
+        *out = f->dados[f->inicio];
+        f->inicio = (f->inicio + 1) % HOST_FIFO_TAM;
+        f->quantidade--;
+        pthread_cond_broadcast(&fifo_cond);
+    }
+    pthread_mutex_unlock(&fifo_mutex);
+    return ok;
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+    uint32_t dado;
+    fifo_retira(-1, &dado);
+    return dado;
+}
+
+bool multicore_fifo_pop_timeout_us(uint64_t timeout_us, uint32_t *out) {
+    return fifo_retira((int64_t)timeout_us, out);
+}
@@ -0,0 +1,160 @@
+// Ponte entre sockets TCP de verdade e a pilha em memória (host/rede.c): cada conexão aceita
+// numa porta local vira uma conexão host_rede_conecta() com a porta do firmware, e os bytes são
+// copiados nos dois sentidos. Assim um navegador, o curl ou o gerador de carga (host/carga.c)
+// falam com o servidor de main.c sem passar pelo Wi-Fi, mas com os limites do lwipopts.h.
+//
+// Cada conexão usa duas threads: uma lê o socket e entrega ao firmware, a outra espera a saída
+// do firmware e a escreve no socket. A segunda é a dona da conexão e a fecha no fim.
+#include "pico/stdlib.h"
+#include "host/rede.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define PONTE_BUF 2048
+#define PONTE_ESPERA_US 20000      // Intervalo em que a saída confere se o socket acabou
+#define PONTE_DRENO_US 200000      // Depois do fim do socket, espera a resposta por até 200 ms
+
+typedef struct {
+    int fd;
+    host_cliente_t *c;
+    atomic_bool socket_fim;   // O cliente fechou o seu lado (ou o socket falhou)
+    atomic_bool socket_erro;  // O socket falhou: a conexão com o firmware é resetada
+    atomic_bool resetada;     // O firmware resetou a conexão
+} ponte_t;
+
+static uint16_t porta_firmware;
+
+// Entrega ao firmware tudo o que chegar pelo socket, esperando a janela TCP quando preciso
+static void *entrada_laco(void *arg) {
+    ponte_t *p = arg;
+    char buf[PONTE_BUF];
+
+    while (true) {
+        ssize_t n = recv(p->fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            if (n < 0) p->socket_erro = true;
+            break;
+        }
+        for (ssize_t feito = 0; feito < n;) {
+            int e = host_rede_envia(p->c, buf + feito, n - feito);
+            if (e < 0) {
+                p->resetada = true;
+                p->socket_fim = true;
+                return NULL;
+            }
+            if (e == 0) sleep_us(100);   // Janela cheia ou sem pbufs livres
+            feito += e;
+        }
+    }
+    p->socket_fim = true;
+    return NULL;
+}
+
+// Escreve no socket o que o firmware enviar, até um dos dois lados fechar
+static void *conexao_laco(void *arg) {
+    ponte_t *p = arg;
+    char buf[PONTE_BUF];
+    pthread_t entrada;
+    uint64_t prazo_dreno = 0;
+
+    pthread_create(&entrada, NULL, entrada_laco, p);
+
+    while (!p->resetada) {
+        bool pronto = host_rede_espera(p->c, PONTE_ESPERA_US);
+        int n = host_rede_recebe(p->c, buf, sizeof(buf));
+        if (n < 0) {
+            p->resetada = true;
+            break;
+        }
+        if (n > 0 && send(p->fd, buf, n, MSG_NOSIGNAL) != n) {
+            p->socket_erro = true;
+            break;
+        }
+        if (host_rede_fechada(p->c)) break;
+
+        // O cliente fechou: ainda entrega o que o firmware responder, até ele ficar quieto
+        if (p->socket_fim) {
+            if (p->socket_erro) break;
+            if (n > 0 || !prazo_dreno) prazo_dreno = time_us_64() + PONTE_DRENO_US;
+            else if (!pronto && time_us_64() > prazo_dreno) break;
+        }
+    }
+
+    // Um reset de um lado vira um reset do outro (SO_LINGER zerado faz o close() mandar RST)
+    if (p->resetada) {
+        struct linger l = { .l_onoff = 1, .l_linger = 0 };
+        setsockopt(p->fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+    }
+    shutdown(p->fd, SHUT_RDWR);   // Acorda o recv() da entrada
+    pthread_join(entrada, NULL);
+
+    if (p->socket_erro) host_rede_reseta(p->c);
+    else host_rede_fecha(p->c);
+    close(p->fd);
+    free(p);
+    return NULL;
+}
+
+static void *aceita_laco(void *arg) {
+    int escuta = (int)(intptr_t)arg;
+
+    while (true) {
+        int fd = accept(escuta, NULL, NULL);
+        if (fd < 0) continue;
+
+        // Como o firmware, que desliga o algoritmo de Nagle nas conexões
+        int um = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+
+        host_cliente_t *c = host_rede_conecta(porta_firmware);
+        if (!c) {
+            // Sem PCB livre: a placa responderia com RST
+            struct linger l = { .l_onoff = 1, .l_linger = 0 };
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+            close(fd);
+            continue;
+        }
+
+        ponte_t *p = calloc(1, sizeof(*p));
+        pthread_t t;
+        p->fd = fd;
+        p->c = c;
+        pthread_create(&t, NULL, conexao_laco, p);
+        pthread_detach(t);
+    }
+    return NULL;
+}
+
+bool host_ponte_inicia(uint16_t porta_local, uint16_t porta) {
+    struct sockaddr_in end = {
+        .sin_family = AF_INET,
+        .sin_port = htons(porta_local),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int um = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    pthread_t t;
+
+    if (fd < 0) {
+        perror("ponte: socket");
+        return false;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+    if (bind(fd, (struct sockaddr *)&end, sizeof(end)) < 0 || listen(fd, 128) < 0) {
+        fprintf(stderr, "ponte: não foi possível escutar em 127.0.0.1:%u\n", porta_local);
+        close(fd);
+        return false;
+    }
+
+    porta_firmware = porta;
+    pthread_create(&t, NULL, aceita_laco, (void *)(intptr_t)fd);
+    pthread_detach(t);
+    return true;
+}
@@ -0,0 +1,836 @@
+// Pilha TCP em memória do host: implementa a API raw do lwIP usada pelo firmware e o lado do
+// cliente de host/rede.h. Não há pacotes nem retransmissões, mas os limites que o firmware
+// precisa respeitar são os mesmos da placa: janela de recepção (TCP_WND), buffer e fila de envio
+// (TCP_SND_BUF, TCP_SND_QUEUELEN), pool de pbufs (PBUF_POOL_SIZE) e de PCBs (MEMP_NUM_TCP_PCB).
+// O comportamento segue o do lwIP 2.1: dados recusados pelo recv são entregues de novo pelo
+// temporizador rápido, tcp_close() com dados não lidos reseta a conexão, dados recebidos depois
+// do tcp_close() abortam o PCB, e sem PCB livre o de menor prioridade é abortado. As escritas
+// também respeitam os pools de segmentos e de pbufs e o heap (MEMP_NUM_TCP_SEG, MEMP_NUM_PBUF,
+// MEM_SIZE), e o uso de cada um aparece em lwip_stats, como com MEMP_STATS e MEM_STATS.
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "lwip/tcp.h"
+#include "lwip/pbuf.h"
+#include "lwip/ip_addr.h"
+#include "lwip/stats.h"
+#include "host/rede.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HOST_ESCUTAS 2          // MEMP_NUM_TCP_PCB_LISTEN
+#define HOST_TCP_TMR_MS 250     // TCP_TMR_INTERVAL: o temporizador lento (tcp_poll) roda a cada dois
+#define HOST_PBUF_RAM_EXTRA 80  // Heap de cada segmento além dos dados: struct pbuf e cabeçalhos
+
+typedef enum {
+    PCB_LIVRE,
+    PCB_NOVO,        // tcp_new(), ainda sem tcp_listen()
+    PCB_ESCUTA,
+    PCB_CONECTADO,
+} pcb_estado_t;
+
+typedef struct {
+    u16_t tam;
+    u8_t pbufs;      // Quanto o segmento ocupa de tcp_sndqueuelen()
+} segmento_t;
+
+struct tcp_pcb {
+    pcb_estado_t estado;
+    uint32_t geracao;        // Muda a cada alocação: detecta um PCB liberado durante um callback
+    u16_t porta;
+    u8_t prio;
+    void *arg;
+    tcp_accept_fn accept;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_poll_fn poll;
+    tcp_err_fn err;
+    u8_t poll_intervalo, poll_contador;
+    u32_t inativo;           // Ticks do temporizador lento sem dados nem confirmações
+
+    // Do cliente para o firmware
+    struct pbuf *recusados;  // Recusados pelo recv (ERR_MEM), entregues de novo depois
+    u32_t janela_usada;      // Entregue e ainda não liberado com tcp_recved()
+    bool fin_cliente, fin_entregue;
+    bool rx_fechado;         // tcp_close(): o firmware não recebe mais nada
+
+    // Do firmware para o cliente (contadores de bytes: confirmado <= visivel <= escrito)
+    u8_t tx[TCP_SND_BUF];
+    u32_t confirmado, visivel, escrito;
+    segmento_t segs[TCP_SND_QUEUELEN];
+    u16_t seg_inicio, seg_quantidade, seg_confirmado;
+    u16_t fila;
+    bool tx_fechado;         // FIN enfileirado
+
+    host_cliente_t *cliente; // NULL depois que o cliente fechou
+};
+
+struct host_cliente {
+    struct tcp_pcb *pcb;     // NULL depois que o PCB foi liberado
+    bool resetada;
+};
+
+static struct tcp_pcb pcbs[MEMP_NUM_TCP_PCB];
+static struct tcp_pcb escutas[HOST_ESCUTAS];
+static uint32_t proxima_geracao;
+static struct pbuf pool[PBUF_POOL_SIZE];
+
+static struct stats_mem memp_stats[MEMP_MAX] = {
+    [MEMP_TCP_PCB]        = { .avail = MEMP_NUM_TCP_PCB },
+    [MEMP_TCP_PCB_LISTEN] = { .avail = HOST_ESCUTAS },
+    [MEMP_TCP_SEG]        = { .avail = MEMP_NUM_TCP_SEG },
+    [MEMP_PBUF]           = { .avail = MEMP_NUM_PBUF },
+    [MEMP_PBUF_POOL]      = { .avail = PBUF_POOL_SIZE },
+};
+
+struct stats_ lwip_stats = {
+    .mem = { .avail = MEM_SIZE },
+    .memp = {
+        [MEMP_TCP_PCB]        = &memp_stats[MEMP_TCP_PCB],
+        [MEMP_TCP_PCB_LISTEN] = &memp_stats[MEMP_TCP_PCB_LISTEN],
+        [MEMP_TCP_SEG]        = &memp_stats[MEMP_TCP_SEG],
+        [MEMP_PBUF]           = &memp_stats[MEMP_PBUF],
+        [MEMP_PBUF_POOL]      = &memp_stats[MEMP_PBUF_POOL],
+    },
+};
+
+static pthread_cond_t rede_cond;   // Saída, fim ou reset em alguma conexão
+static pthread_once_t rede_once = PTHREAD_ONCE_INIT;
+static pthread_once_t thread_once = PTHREAD_ONCE_INIT;
+static pthread_t rede_thread;
+
+static void rede_cond_inicia(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&rede_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void trava(void) {
+    pthread_once(&rede_once, rede_cond_inicia);
+    pthread_mutex_lock(host_lwip_lock());
+}
+
+static void destrava(void) {
+    pthread_mutex_unlock(host_lwip_lock());
+}
+
+// Espera em rede_cond (com o lock do lwIP tomado uma única vez) até o prazo em µs do relógio
+// da simulação; retorna false se o prazo passou
+static bool espera_ate(uint64_t prazo_us) {
+    int64_t falta_us = (int64_t)(prazo_us - time_us_64());
+    struct timespec ts;
+
+    if (falta_us <= 0) return false;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += falta_us / 1000000;
+    ts.tv_nsec += (falta_us % 1000000) * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_cond_timedwait(&rede_cond, host_lwip_lock(), &ts) != ETIMEDOUT;
+}
+
+//====================================
+//      Estatísticas
+//====================================
+
+// Reserva n unidades de um pool (ou bytes do heap); sem espaço, conta a falha e retorna false
+static bool stats_usa(struct stats_mem *m, u32_t n) {
+    if (m->used + n > m->avail) {
+        m->err++;
+        return false;
+    }
+    m->used += n;
+    if (m->used > m->max) m->max = m->used;
+    return true;
+}
+
+static void stats_libera(struct stats_mem *m, u32_t n) {
+    m->used -= n;
+}
+
+// Heap usado por um segmento: os dados (com cópia) e o pbuf do cabeçalho
+static inline u32_t segmento_heap(const segmento_t *s) {
+    return (s->pbufs == 1 ? s->tam : 0) + HOST_PBUF_RAM_EXTRA;
+}
+
+static void segmento_libera(const segmento_t *s) {
+    stats_libera(&memp_stats[MEMP_TCP_SEG], 1);
+    if (s->pbufs == 2) stats_libera(&memp_stats[MEMP_PBUF], 1);
+    stats_libera(&lwip_stats.mem, segmento_heap(s));
+}
+
+//====================================
+//      pbufs
+//====================================
+
+static struct pbuf *pbuf_aloca(void) {
+    for (int i = 0; i < PBUF_POOL_SIZE; i++) {
+        struct pbuf *p = &pool[i];
+        if (p->ref) continue;
+        stats_usa(&memp_stats[MEMP_PBUF_POOL], 1);
+        p->next = NULL;
+        p->payload = p->dados;
+        p->len = p->tot_len = 0;
+        p->ref = 1;
+        return p;
+    }
+    memp_stats[MEMP_PBUF_POOL].err++;
+    return NULL;
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+    u8_t liberados = 0;
+
+    while (p) {
+        if (p->ref == 0) {
+            fprintf(stderr, "host: pbuf_free() de um pbuf já livre\n");
+            abort();
+        }
+        if (--p->ref) break;
+        struct pbuf *prox = p->next;
+        p->next = NULL;
+        stats_libera(&memp_stats[MEMP_PBUF_POOL], 1);
+        liberados++;
+        p = prox;
+    }
+    return liberados;
+}
+
+void pbuf_cat(struct pbuf *head, struct pbuf *tail) {
+    struct pbuf *p = head;
+
+    for (; p->next; p = p->next) p->tot_len += tail->tot_len;
+    p->tot_len += tail->tot_len;
+    p->next = tail;
+}
+
+u16_t pbuf_clen(const struct pbuf *p) {
+    u16_t n = 0;
+
+    for (; p; p = p->next) n++;
+    return n;
+}
+
+struct pbuf *pbuf_free_header(struct pbuf *q, u16_t size) {
+    struct pbuf *p = q;
+
+    while (size && p) {
+        if (size >= p->len) {
+            struct pbuf *f = p;
+            size -= p->len;
+            p = p->next;
+            f->next = NULL;
+            pbuf_free(f);
+        } else {
+            p->payload = (u8_t *)p->payload + size;
+            p->len -= size;
+            p->tot_len -= size;
+            size = 0;
+        }
+    }
+    return p;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset) {
+    u16_t copiados = 0;
+
+    for (; p && len; p = p->next) {
+        if (offset >= p->len) {
+            offset -= p->len;
+            continue;
+        }
+        u16_t n = p->len - offset;
+        if (n > len) n = len;
+        memcpy((u8_t *)dataptr + copiados, (const u8_t *)p->payload + offset, n);
+        copiados += n;
+        len -= n;
+        offset = 0;
+    }
+    return copiados;
+}
+
+//====================================
+//      Endereços
+//====================================
+
+const ip_addr_t ip_addr_any = { 0 };
+
+char *ipaddr_ntoa(const ip_addr_t *addr) {
+    static char texto[16];
+    const u8_t *b = (const u8_t *)&addr->addr;
+
+    snprintf(texto, sizeof(texto), "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
+    return texto;
+}
+
+//====================================
+//      PCBs
+//====================================
+
+static inline bool vivo(const struct tcp_pcb *pcb, uint32_t geracao) {
+    return pcb->estado == PCB_CONECTADO && pcb->geracao == geracao;
+}
+
+// Muda o estado do PCB, contando os PCBs em uso no pool dele; um PCB liberado devolve os
+// segmentos que ainda esperavam confirmação
+static void pcb_estado(struct tcp_pcb *pcb, pcb_estado_t estado) {
+    bool escuta = pcb >= escutas && pcb < escutas + HOST_ESCUTAS;
+    struct stats_mem *m = &memp_stats[escuta ? MEMP_TCP_PCB_LISTEN : MEMP_TCP_PCB];
+
+    if (pcb->estado == PCB_LIVRE && estado != PCB_LIVRE) stats_usa(m, 1);
+    if (pcb->estado != PCB_LIVRE && estado == PCB_LIVRE) {
+        stats_libera(m, 1);
+        for (u16_t i = 0; i < pcb->seg_quantidade; i++) {
+            segmento_libera(&pcb->segs[(pcb->seg_inicio + i) % TCP_SND_QUEUELEN]);
+        }
+        pcb->seg_quantidade = 0;
+    }
+    pcb->estado = estado;
+}
+
+// Libera o PCB; o cliente, se ainda houver, vê o fim da conexão (ou um reset)
+static void pcb_libera(struct tcp_pcb *pcb, bool reset) {
+    if (pcb->recusados) pbuf_free(pcb->recusados);
+    if (pcb->cliente) {
+        pcb->cliente->pcb = NULL;
+        pcb->cliente->resetada = reset;
+    }
+    pcb_estado(pcb, PCB_LIVRE);
+    pthread_cond_broadcast(&rede_cond);
+}
+
+void tcp_abort(struct tcp_pcb *pcb) {
+    if (pcb->estado != PCB_CONECTADO) {
+        pcb_estado(pcb, PCB_LIVRE);
+        return;
+    }
+
+    tcp_err_fn err = pcb->err;
+    void *arg = pcb->arg;
+    pcb_libera(pcb, true);
+    if (err) err(arg, ERR_ABRT);
+    host_contexto_acorda();
+}
+
+static void verifica_fim(struct tcp_pcb *pcb);
+
+// Sem PCB livre, o lwIP aborta a conexão de prioridade mais baixa que a nova (e, entre as de
+// mesma prioridade, a inativa há mais tempo)
+static struct tcp_pcb *pcb_aloca(u8_t prio) {
+    struct tcp_pcb *pcb = NULL;
+
+    for (int i = 0; i < MEMP_NUM_TCP_PCB && !pcb; i++) {
+        if (pcbs[i].estado == PCB_LIVRE) pcb = &pcbs[i];
+    }
+
+    // Conexões fechadas dos dois lados que a thread da rede ainda não liberou estão em
+    // TIME_WAIT, e o lwIP reaproveita essas primeiro (tcp_kill_timewait)
+    for (int i = 0; i < MEMP_NUM_TCP_PCB && !pcb; i++) {
+        if (pcbs[i].estado != PCB_CONECTADO) continue;
+        verifica_fim(&pcbs[i]);
+        if (pcbs[i].estado == PCB_LIVRE) pcb = &pcbs[i];
+    }
+    if (!pcb && prio > 0) {
+        u8_t mprio = (prio > TCP_PRIO_MAX ? TCP_PRIO_MAX : prio) - 1;
+        u32_t inatividade = 0;
+        struct tcp_pcb *vitima = NULL;
+
+        for (int i = 0; i < MEMP_NUM_TCP_PCB; i++) {
+            struct tcp_pcb *p = &pcbs[i];
+            if (p->estado != PCB_CONECTADO) continue;
+            if (p->prio < mprio || (p->prio == mprio && p->inativo >= inatividade)) {
+                inatividade = p->inativo;
+                mprio = p->prio;
+                vitima = p;
+            }
+        }
+        if (vitima) {
+            tcp_abort(vitima);
+            pcb = vitima;
+        }
+    }
+    if (!pcb) {
+        memp_stats[MEMP_TCP_PCB].err++;
+        return NULL;
+    }
+
+    uint32_t geracao = ++proxima_geracao;
+    memset(pcb, 0, offsetof(struct tcp_pcb, tx));
+    memset(&pcb->confirmado, 0, sizeof(*pcb) - offsetof(struct tcp_pcb, confirmado));
+    pcb->geracao = geracao;
+    pcb->prio = TCP_PRIO_NORMAL;
+    pcb_estado(pcb, PCB_NOVO);
+    return pcb;
+}
+
+static struct tcp_pcb *escuta(u16_t porta) {
+    for (int i = 0; i < HOST_ESCUTAS; i++) {
+        if (escutas[i].estado == PCB_ESCUTA && escutas[i].porta == porta) return &escutas[i];
+    }
+    return NULL;
+}
+
+// tcp_output(): o que foi escrito fica visível para o cliente
+static void saida(struct tcp_pcb *pcb) {
+    if (pcb->visivel == pcb->escrito) return;
+    pcb->visivel = pcb->escrito;
+    pthread_cond_broadcast(&rede_cond);
+}
+
+// Com os dois lados fechados e tudo confirmado, o PCB vai para TIME_WAIT, que aqui o libera
+static void verifica_fim(struct tcp_pcb *pcb) {
+    if (pcb->rx_fechado && pcb->tx_fechado && pcb->confirmado == pcb->escrito &&
+        (pcb->fin_cliente || !pcb->cliente)) {
+        pcb_libera(pcb, false);
+    }
+}
+
+// Entrega ao firmware um segmento (ou o FIN, com p NULL), como tcp_input() faz
+static err_t chama_recv(struct tcp_pcb *pcb, struct pbuf *p) {
+    pcb->inativo = 0;
+    host_contexto_acorda();
+    if (pcb->recv) return pcb->recv(pcb->arg, pcb, p, ERR_OK);
+
+    // tcp_recv_null(): sem callback, os dados são descartados e o FIN fecha o PCB
+    if (p) {
+        tcp_recved(pcb, p->tot_len);
+        pbuf_free(p);
+    } else {
+        tcp_close(pcb);
+    }
+    return ERR_OK;
+}
+
+// Reentrega os dados recusados e, depois deles, o FIN do cliente
+static void entrega_rx(struct tcp_pcb *pcb) {
+    uint32_t geracao = pcb->geracao;
+
+    if (pcb->recusados) {
+        struct pbuf *p = pcb->recusados;
+        pcb->recusados = NULL;
+        err_t e = chama_recv(pcb, p);
+        if (!vivo(pcb, geracao)) return;
+        if (e != ERR_OK) {
+            pcb->recusados = p;
+            return;
+        }
+    }
+    if (pcb->fin_cliente && !pcb->fin_entregue) {
+        pcb->fin_entregue = true;
+        if (!pcb->rx_fechado) {
+            chama_recv(pcb, NULL);
+            if (!vivo(pcb, geracao)) return;
+        }
+    }
+    saida(pcb);
+}
+
+// O cliente confirmou n bytes: libera os segmentos cobertos e chama o callback sent
+static void confirma(struct tcp_pcb *pcb, u32_t n) {
+    uint32_t geracao = pcb->geracao;
+    u32_t resto = n;
+
+    pcb->confirmado += n;
+    while (resto && pcb->seg_quantidade) {
+        segmento_t *s = &pcb->segs[pcb->seg_inicio];
+        u32_t falta = s->tam - pcb->seg_confirmado;
+        if (resto < falta) {
+            pcb->seg_confirmado += resto;
+            break;
+        }
+        resto -= falta;
+        segmento_libera(s);
+        pcb->fila -= s->pbufs;
+        pcb->seg_inicio = (pcb->seg_inicio + 1) % TCP_SND_QUEUELEN;
+        pcb->seg_quantidade--;
+        pcb->seg_confirmado = 0;
+    }
+
+    pcb->inativo = 0;
+    host_contexto_acorda();
+    if (pcb->sent) {
+        pcb->sent(pcb->arg, pcb, (u16_t)n);
+        if (!vivo(pcb, geracao)) return;
+    }
+    saida(pcb);
+    verifica_fim(pcb);
+}
+
+// Temporizador lento: tcp_poll de cada conexão no seu intervalo
+static void temporizador_lento(void) {
+    for (int i = 0; i < MEMP_NUM_TCP_PCB; i++) {
+        struct tcp_pcb *pcb = &pcbs[i];
+        if (pcb->estado != PCB_CONECTADO) continue;
+
+        uint32_t geracao = pcb->geracao;
+        pcb->inativo++;
+        if (++pcb->poll_contador < pcb->poll_intervalo) continue;
+        pcb->poll_contador = 0;
+        if (pcb->poll) {
+            host_contexto_acorda();
+            pcb->poll(pcb->arg, pcb);
+            if (!vivo(pcb, geracao)) continue;
+        }
+        saida(pcb);
+    }
+}
+
+// Thread dos temporizadores do TCP; também confirma sozinha o que o firmware envia para
+// conexões que o cliente já fechou
+static void *rede_laco(void *arg) {
+    (void)arg;
+    uint64_t proximo = time_us_64() + HOST_TCP_TMR_MS * 1000;
+    uint32_t ticks = 0;
+
+    trava();
+    while (true) {
+        bool mudou;
+        do {
+            mudou = false;
+            for (int i = 0; i < MEMP_NUM_TCP_PCB; i++) {
+                struct tcp_pcb *pcb = &pcbs[i];
+                if (pcb->estado != PCB_CONECTADO || pcb->cliente) continue;
+                if (pcb->visivel != pcb->confirmado) {
+                    confirma(pcb, pcb->visivel - pcb->confirmado);
+                    mudou = true;
+                } else {
+                    verifica_fim(pcb);
+                }
+            }
+        } while (mudou);
+
+        if ((int64_t)(time_us_64() - proximo) >= 0) {
+            proximo += HOST_TCP_TMR_MS * 1000;
+            for (int i = 0; i < MEMP_NUM_TCP_PCB; i++) {
+                if (pcbs[i].estado == PCB_CONECTADO && pcbs[i].recusados) entrega_rx(&pcbs[i]);
+            }
+            if (++ticks % 2 == 0) temporizador_lento();
+            continue;
+        }
+        espera_ate(proximo);
+    }
+    return NULL;
+}
+
+static void rede_thread_inicia(void) {
+    pthread_once(&rede_once, rede_cond_inicia);
+    pthread_create(&rede_thread, NULL, rede_laco, NULL);
+}
+
+void host_rede_inicia(void) {
+    pthread_once(&thread_once, rede_thread_inicia);
+}
+
+//====================================
+//      API raw do lwIP
+//====================================
+
+struct tcp_pcb *tcp_new(void) {
+    return pcb_aloca(TCP_PRIO_NORMAL);
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    (void)ipaddr;
+    if (escuta(port)) return ERR_USE;
+    pcb->porta = port;
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen(struct tcp_pcb *pcb) {
+    for (int i = 0; i < HOST_ESCUTAS; i++) {
+        struct tcp_pcb *l = &escutas[i];
+        if (l->estado != PCB_LIVRE) continue;
+
+        memset(l, 0, offsetof(struct tcp_pcb, tx));
+        pcb_estado(l, PCB_ESCUTA);
+        l->porta = pcb->porta;
+        l->prio = pcb->prio;
+        l->arg = pcb->arg;
+        pcb_estado(pcb, PCB_LIVRE);
+        return l;
+    }
+    return NULL;
+}
+
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept) {
+    pcb->accept = accept;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg) {
+    pcb->arg = arg;
+}
+
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv) {
+    pcb->recv = recv;
+}
+
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent) {
+    pcb->sent = sent;
+}
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval) {
+    pcb->poll = poll;
+    pcb->poll_intervalo = interval;
+}
+
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err) {
+    pcb->err = err;
+}
+
+void tcp_setprio(struct tcp_pcb *pcb, u8_t prio) {
+    pcb->prio = prio;
+}
+
+void tcp_nagle_disable(struct tcp_pcb *pcb) {
+    (void)pcb;
+}
+
+u16_t tcp_sndbuf(const struct tcp_pcb *pcb) {
+    if (pcb->estado != PCB_CONECTADO) return 0;
+    return TCP_SND_BUF - (pcb->escrito - pcb->confirmado);
+}
+
+u16_t tcp_sndqueuelen(const struct tcp_pcb *pcb) {
+    return pcb->fila;
+}
+
+// Cada escrita ocupa segmentos próprios de até TCP_MSS bytes; sem TCP_WRITE_FLAG_COPY, cada
+// segmento usa dois pbufs (cabeçalho e referência aos dados), como no lwIP
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags) {
+    if (pcb->estado != PCB_CONECTADO || pcb->tx_fechado) return ERR_CONN;
+    if (len == 0) return ERR_OK;
+    if (len > tcp_sndbuf(pcb)) return ERR_MEM;
+
+    u16_t segmentos = (len + TCP_MSS - 1) / TCP_MSS;
+    u8_t por_segmento = (apiflags & TCP_WRITE_FLAG_COPY) ? 1 : 2;
+    if (pcb->fila + segmentos * por_segmento > TCP_SND_QUEUELEN) return ERR_MEM;
+
+    // Segmentos, pbufs de referência e heap são reservados de uma vez: sem espaço, nada é escrito
+    u32_t heap = segmentos * HOST_PBUF_RAM_EXTRA + (por_segmento == 1 ? len : 0);
+    if (!stats_usa(&memp_stats[MEMP_TCP_SEG], segmentos)) return ERR_MEM;
+    if (por_segmento == 2 && !stats_usa(&memp_stats[MEMP_PBUF], segmentos)) {
+        stats_libera(&memp_stats[MEMP_TCP_SEG], segmentos);
+        return ERR_MEM;
+    }
+    if (!stats_usa(&lwip_stats.mem, heap)) {
+        stats_libera(&memp_stats[MEMP_TCP_SEG], segmentos);
+        if (por_segmento == 2) stats_libera(&memp_stats[MEMP_PBUF], segmentos);
+        return ERR_MEM;
+    }
+
+    const u8_t *dados = dataptr;
+    for (u16_t feito = 0; feito < len;) {
+        u16_t n = len - feito > TCP_MSS ? TCP_MSS : len - feito;
+        segmento_t *s = &pcb->segs[(pcb->seg_inicio + pcb->seg_quantidade++) % TCP_SND_QUEUELEN];
+        s->tam = n;
+        s->pbufs = por_segmento;
+        pcb->fila += por_segmento;
+        lwip_stats.link.xmit++;
+
+        for (u16_t i = 0; i < n; i++) pcb->tx[(pcb->escrito + i) % TCP_SND_BUF] = dados[feito + i];
+        pcb->escrito += n;
+        feito += n;
+    }
+    return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    if (pcb->estado == PCB_CONECTADO) saida(pcb);
+    return ERR_OK;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len) {
+    pcb->janela_usada = len > pcb->janela_usada ? 0 : pcb->janela_usada - len;
+}
+
+err_t tcp_close(struct tcp_pcb *pcb) {
+    if (pcb->estado != PCB_CONECTADO) {
+        pcb_estado(pcb, PCB_LIVRE);
+        return ERR_OK;
+    }
+
+    // Dados recebidos e não lidos: o lwIP envia um RST e libera o PCB na hora, sem chamar err
+    if (pcb->recusados || pcb->janela_usada > 0) {
+        pcb_libera(pcb, true);
+        return ERR_OK;
+    }
+
+    pcb->rx_fechado = true;
+    pcb->tx_fechado = true;
+    saida(pcb);
+    pthread_cond_broadcast(&rede_cond);
+    return ERR_OK;
+}
+
+err_t tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx) {
+    if (pcb->estado != PCB_CONECTADO) return ERR_CONN;
+    if (shut_rx && shut_tx) return tcp_close(pcb);
+
+    if (shut_rx) {
+        pcb->rx_fechado = true;
+        if (pcb->recusados) pbuf_free(pcb->recusados);
+        pcb->recusados = NULL;
+    }
+    if (shut_tx) {
+        pcb->tx_fechado = true;
+        saida(pcb);
+        pthread_cond_broadcast(&rede_cond);
+    }
+    return ERR_OK;
+}
+
+//====================================
+//      Lado do cliente
+//====================================
+
+bool host_rede_escutando(uint16_t porta) {
+    trava();
+    struct tcp_pcb *l = escuta(porta);
+    bool escutando = l && l->accept;
+    destrava();
+    return escutando;
+}
+
+host_cliente_t *host_rede_conecta(uint16_t porta) {
+    trava();
+    struct tcp_pcb *l = escuta(porta);
+    struct tcp_pcb *pcb = (l && l->accept) ? pcb_aloca(l->prio) : NULL;
+    if (!pcb) {
+        destrava();
+        return NULL;
+    }
+
+    host_cliente_t *c = calloc(1, sizeof(*c));
+    c->pcb = pcb;
+    pcb->cliente = c;
+    pcb->estado = PCB_CONECTADO;
+    pcb->prio = l->prio;
+    pcb->arg = l->arg;
+
+    uint32_t geracao = pcb->geracao;
+    host_contexto_acorda();
+    err_t e = l->accept(l->arg, pcb, ERR_OK);
+    if (vivo(pcb, geracao)) {
+        if (e != ERR_OK) tcp_abort(pcb);
+        else saida(pcb);
+    }
+    destrava();
+    return c;
+}
+
+int host_rede_envia(host_cliente_t *c, const void *dados, size_t tam) {
+    trava();
+    struct tcp_pcb *pcb = c->pcb;
+    if (!pcb) {
+        destrava();
+        return -1;
+    }
+
+    // Dados depois do tcp_close(): o lwIP aborta a conexão
+    if (pcb->rx_fechado) {
+        if (tam > 0) tcp_abort(pcb);
+        destrava();
+        return tam > 0 ? -1 : 0;
+    }
+
+    // Enquanto houver dados recusados, os novos segmentos são descartados (e retransmitidos)
+    if (pcb->recusados) entrega_rx(pcb);
+
+    uint32_t geracao = pcb->geracao;
+    size_t enviados = 0;
+    while (vivo(pcb, geracao) && !pcb->recusados && enviados < tam && pcb->janela_usada < TCP_WND) {
+        struct pbuf *p = pbuf_aloca();
+        if (!p) break;
+
+        size_t n = tam - enviados;
+        if (n > TCP_MSS) n = TCP_MSS;
+        if (n > TCP_WND - pcb->janela_usada) n = TCP_WND - pcb->janela_usada;
+        memcpy(p->dados, (const u8_t *)dados + enviados, n);
+        p->len = p->tot_len = n;
+        lwip_stats.link.recv++;
+        pcb->janela_usada += n;
+        enviados += n;
+
+        if (chama_recv(pcb, p) != ERR_OK && vivo(pcb, geracao)) pcb->recusados = p;
+    }
+    if (vivo(pcb, geracao)) saida(pcb);
+
+    int resultado = c->pcb ? (int)enviados : (c->resetada ? -1 : (int)enviados);
+    destrava();
+    return resultado;
+}
+
+int host_rede_recebe(host_cliente_t *c, void *buf, size_t max) {
+    trava();
+    struct tcp_pcb *pcb = c->pcb;
+    if (!pcb) {
+        destrava();
+        return c->resetada ? -1 : 0;
+    }
+
+    u32_t n = pcb->visivel - pcb->confirmado;
+    if (n > max) n = max;
+    for (u32_t i = 0; i < n; i++) ((u8_t *)buf)[i] = pcb->tx[(pcb->confirmado + i) % TCP_SND_BUF];
+    if (n) confirma(pcb, n);
+    destrava();
+    return (int)n;
+}
+
+static bool fechada(const host_cliente_t *c) {
+    if (!c->pcb) return !c->resetada;
+    return c->pcb->tx_fechado && c->pcb->confirmado == c->pcb->escrito;
+}
+
+bool host_rede_fechada(host_cliente_t *c) {
+    trava();
+    bool f = fechada(c);
+    destrava();
+    return f;
+}
+
+bool host_rede_espera(host_cliente_t *c, uint64_t timeout_us) {
+    uint64_t prazo = time_us_64() + timeout_us;
+    bool pronto;
+
+    trava();
+    while (!(pronto = !c->pcb || c->pcb->visivel != c->pcb->confirmado || fechada(c))) {
+        if (!espera_ate(prazo) && (int64_t)(time_us_64() - prazo) >= 0) break;
+    }
+    destrava();
+    return pronto;
+}
+
+void host_rede_fecha(host_cliente_t *c) {
+    trava();
+    struct tcp_pcb *pcb = c->pcb;
+    free(c);
+    if (pcb) {
+        pcb->cliente = NULL;
+        pcb->fin_cliente = true;
+        entrega_rx(pcb);
+        pthread_cond_broadcast(&rede_cond);   // A thread da rede confirma o resto
+    }
+    destrava();
+}
+
+void host_rede_reseta(host_cliente_t *c) {
+    trava();
+    struct tcp_pcb *pcb = c->pcb;
+    free(c);
+    if (pcb) {
+        tcp_err_fn err = pcb->err;
+        void *arg = pcb->arg;
+        pcb->cliente = NULL;
+        pcb_libera(pcb, true);
+        if (err) err(arg, ERR_RST);
+        host_contexto_acorda();
+    }
+    destrava();
+}
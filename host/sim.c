@@ -0,0 +1,368 @@
+// Simulação do firmware no computador: roda o main() do firmware (compilado como
+// robovigia_main) sobre os substitutos de host/, com o núcleo 1, os alarmes e os temporizadores
+// do TCP em threads. Uma thread de teste faz as vezes do cliente Wi-Fi:
+//
+//   robovigia_sim [-c SEQ]... [-n N] [-x STATUS] [-e N] [-l N] [-t MS] [-p PORTA] [-T ARQUIVO] [-q]
+//
+//   -c SEQ    envia GET /cmd?seq=SEQ (pode repetir; todas pela mesma conexão keep-alive)
+//   -n N      repete a lista de sequências N vezes
+//   -x STATUS status esperado para as sequências (padrão 200); com outro, o firmware fecha a
+//             conexão e só a primeira é enviada
+//   -e N      abre N conexões, uma de cada vez, com uma requisição malformada e outra encadeada
+//             atrás dela; cada uma deve receber 400 e ser fechada, e depois o /stats deve
+//             responder com só a própria conexão ativa (os slots foram devolvidos)
+//   -l N      N clientes keep-alive pedem /state sem parar por 2 s; com mais clientes que slots,
+//             os que sobram recebem 503 (e esperam 100 ms para tentar de novo), mas nenhum cliente
+//             atendido pode ser derrubado para dar lugar a outro, e os erros ficam abaixo de 10%
+//   -t MS     encerra depois de MS ms (sem -c, o firmware roda até ser interrompido)
+//   -p PORTA  aceita conexões de verdade em 127.0.0.1:PORTA (navegador, curl, robovigia_carga)
+//   -T ARQ    liga o trace ('T' no console) e grava em ARQ o que o firmware envia pela USB
+//   -q        descarta o que o firmware imprime
+//
+// No fim, imprime em stderr o /stats, o último quadro da matriz de LEDs e o tempo das requisições.
+#include "pico/stdlib.h"
+#include "host/hal.h"
+#include "host/rede.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SIM_PORTA 80
+#define SIM_SEQS_MAX 32
+#define SIM_RESPOSTA_MAX 4096
+#define SIM_ESPERA_US 5000000   // Sem resposta em 5 s, a simulação falha
+#define SIM_CARGA_US 2000000    // Duração do teste de carga (-l)
+#define SIM_RECUSA_US 100000    // Espera de um cliente de -l depois de um 503 ou de conexão recusada
+#define SIM_CARGA_CLIENTES_MAX 64
+
+int robovigia_main(void);
+
+static const char *seqs[SIM_SEQS_MAX];
+static int num_seqs;
+static int repeticoes = 1;
+static int status_esperado = 200;
+static uint32_t duracao_ms;
+static uint16_t porta_local;
+static int erros;
+static int carga_clientes;
+
+typedef struct {
+    int respondidas;   // Respostas 200
+    int recusadas;     // 503 ou conexão recusada (o cliente espera e tenta de novo)
+    int derrubadas;    // Conexão keep-alive fechada pelo firmware entre requisições
+} carga_t;
+
+// Envia tudo, esperando a janela TCP reabrir quando preciso; retorna false se a conexão caiu
+static bool envia_tudo(host_cliente_t *c, const char *dados, size_t tam) {
+    uint64_t prazo = time_us_64() + SIM_ESPERA_US;
+
+    while (tam > 0) {
+        int n = host_rede_envia(c, dados, tam);
+        if (n < 0) return false;
+        dados += n;
+        tam -= n;
+        if (n == 0) {
+            if (time_us_64() > prazo) return false;
+            sleep_ms(1);
+        }
+    }
+    return true;
+}
+
+// Faz um GET na conexão e lê a resposta (com Content-Length); retorna o status HTTP, ou -1
+static int requisita(host_cliente_t *c, const char *caminho, char *corpo, size_t max) {
+    char buf[SIM_RESPOSTA_MAX];
+    size_t lidos = 0;
+    int tam_requisicao = snprintf(buf, sizeof(buf), "GET %s HTTP/1.1\r\nHost: robovigia\r\n\r\n", caminho);
+
+    if (!envia_tudo(c, buf, tam_requisicao)) return -1;
+
+    while (true) {
+        buf[lidos] = '\0';
+        char *fim = strstr(buf, "\r\n\r\n");
+        if (fim) {
+            const char *cl = strstr(buf, "Content-Length: ");
+            size_t cabecalho = fim + 4 - buf;
+            size_t tam_corpo = cl ? strtoul(cl + 16, NULL, 10) : 0;
+            if (lidos >= cabecalho + tam_corpo) {
+                if (tam_corpo >= max) tam_corpo = max - 1;
+                memcpy(corpo, buf + cabecalho, tam_corpo);
+                corpo[tam_corpo] = '\0';
+                return atoi(buf + 9);   // "HTTP/1.1 200"
+            }
+        }
+        if (lidos == sizeof(buf) - 1) return -1;
+
+        int n = host_rede_recebe(c, buf + lidos, sizeof(buf) - 1 - lidos);
+        if (n < 0 || (n == 0 && host_rede_fechada(c))) return -1;
+        if (n == 0 && !host_rede_espera(c, SIM_ESPERA_US)) return -1;
+        lidos += n;
+    }
+}
+
+// Lê tudo o que o firmware enviar até ele fechar a conexão; retorna quantos bytes, ou -1 se a
+// conexão foi resetada ou o tempo acabou
+static int le_ate_fechar(host_cliente_t *c, char *buf, size_t max) {
+    size_t lidos = 0;
+
+    while (!host_rede_fechada(c)) {
+        int n = host_rede_recebe(c, buf + lidos, max - 1 - lidos);
+        if (n < 0) return -1;
+        if (n == 0 && !host_rede_espera(c, SIM_ESPERA_US)) return -1;
+        lidos += n;
+        if (lidos == max - 1) break;
+    }
+    buf[lidos] = '\0';
+    return lidos;
+}
+
+// Requisições malformadas com outra encadeada: o firmware responde 400 e fecha, descartando o
+// resto da entrada sem resetar a conexão e sem perder o slot da tabela
+static int testa_erros(int n) {
+    static const char requisicao[] = "BAD\r\n\r\nGET / HTTP/1.1\r\n\r\n";
+    char buf[SIM_RESPOSTA_MAX];
+
+    for (int i = 0; i < n; i++) {
+        host_cliente_t *c = host_rede_conecta(SIM_PORTA);
+        if (!c) {
+            fprintf(stderr, "sim: erro %d: conexão recusada\n", i);
+            return 1;
+        }
+        bool ok = envia_tudo(c, requisicao, sizeof(requisicao) - 1) && le_ate_fechar(c, buf, sizeof(buf)) > 0 &&
+                  strncmp(buf, "HTTP/1.1 400", 12) == 0;
+        host_rede_fecha(c);
+        if (!ok) {
+            fprintf(stderr, "sim: erro %d: esperava 400, recebeu \"%.40s\"\n", i, buf);
+            return 1;
+        }
+    }
+
+    host_cliente_t *c = host_rede_conecta(SIM_PORTA);
+    int status = c ? requisita(c, "/stats", buf, sizeof(buf)) : -1;
+    if (c) host_rede_fecha(c);
+    if (status != 200 || !strstr(buf, "\"ativas\":1,")) {
+        fprintf(stderr, "sim: /stats depois de %d erros -> %d %.80s\n", n, status, status == 200 ? buf : "");
+        return 1;
+    }
+    fprintf(stderr, "%d requisições malformadas respondidas com 400; /stats -> %s\n", n, buf);
+    return 0;
+}
+
+// Um cliente de -l: pede /state pela mesma conexão até o tempo acabar, reconectando quando
+// preciso
+static void *carga_laco(void *arg) {
+    carga_t *r = arg;
+    uint64_t fim = time_us_64() + SIM_CARGA_US;
+    char corpo[SIM_RESPOSTA_MAX];
+    host_cliente_t *c = NULL;
+
+    while (time_us_64() < fim) {
+        bool nova = !c;
+        if (!c && !(c = host_rede_conecta(SIM_PORTA))) {
+            r->recusadas++;
+            sleep_us(SIM_RECUSA_US);
+            continue;
+        }
+
+        int status = requisita(c, "/state", corpo, sizeof(corpo));
+        if (status == 200) {
+            r->respondidas++;
+            continue;
+        }
+        host_rede_fecha(c);
+        c = NULL;
+        if (status == 503 || nova) {
+            r->recusadas++;
+            sleep_us(SIM_RECUSA_US);
+        } else {
+            r->derrubadas++;
+        }
+    }
+    if (c) host_rede_fecha(c);
+    return NULL;
+}
+
+// Mais clientes que slots: quem já foi atendido continua sendo, e os demais recebem 503
+static int testa_carga(int n) {
+    pthread_t threads[SIM_CARGA_CLIENTES_MAX];
+    carga_t r[SIM_CARGA_CLIENTES_MAX] = { 0 }, total = { 0 };
+    char buf[SIM_RESPOSTA_MAX];
+    int status = -1;
+
+    if (n > SIM_CARGA_CLIENTES_MAX) n = SIM_CARGA_CLIENTES_MAX;
+    for (int i = 0; i < n; i++) pthread_create(&threads[i], NULL, carga_laco, &r[i]);
+    for (int i = 0; i < n; i++) {
+        pthread_join(threads[i], NULL);
+        total.respondidas += r[i].respondidas;
+        total.recusadas += r[i].recusadas;
+        total.derrubadas += r[i].derrubadas;
+    }
+
+    // Os slots dos clientes voltam assim que o firmware vê o fim das conexões
+    for (int i = 0; i < 10 && status != 200; i++) {
+        host_cliente_t *c = host_rede_conecta(SIM_PORTA);
+        status = c ? requisita(c, "/stats", buf, sizeof(buf)) : -1;
+        if (c) host_rede_fecha(c);
+        if (status != 200) sleep_us(SIM_RECUSA_US);
+    }
+
+    int tentativas = total.respondidas + total.recusadas + total.derrubadas;
+    double taxa = tentativas ? 100.0 * (total.recusadas + total.derrubadas) / tentativas : 100.0;
+    const char *descartadas = status == 200 ? strstr(buf, "\"descartadas\":") : NULL;
+    fprintf(stderr, "%d clientes: %d respondidas, %d recusadas, %d derrubadas (%.2f%% de erros)\n", n,
+            total.respondidas, total.recusadas, total.derrubadas, taxa);
+    if (!descartadas || strtoul(descartadas + 14, NULL, 10) != 0 || total.derrubadas > 0 || taxa >= 10.0) {
+        fprintf(stderr, "sim: carga com %d clientes -> /stats %d %.160s\n", n, status, status == 200 ? buf : "");
+        return 1;
+    }
+    return 0;
+}
+
+// Imprime a matriz 5x5 como o firmware a enviou à fita (palavras GRB << 8)
+static void imprime_matriz(void) {
+    uint32_t pixels[HOST_WS2812B_MAX], quadros;
+    uint n = host_ws2812b_quadro(pixels, HOST_WS2812B_MAX, &quadros);
+
+    fprintf(stderr, "matriz (%u quadros enviados):\n", quadros);
+    for (uint i = 0; i < n; i++) {
+        uint32_t w = pixels[i];
+        fprintf(stderr, "%s#%02x%02x%02x", i % 5 ? " " : "  ", (w >> 16) & 0xff, w >> 24, (w >> 8) & 0xff);
+        if (i % 5 == 4 || i == n - 1) fprintf(stderr, "\n");
+    }
+}
+
+static void *cliente_laco(void *arg) {
+    (void)arg;
+    uint64_t inicio = time_us_64();
+    char corpo[SIM_RESPOSTA_MAX];
+    int codigo = 0;
+
+    while (!host_rede_escutando(SIM_PORTA)) {
+        if (time_us_64() - inicio > SIM_ESPERA_US) {
+            fprintf(stderr, "sim: o firmware não abriu a porta %d\n", SIM_PORTA);
+            host_encerra(1);
+            return NULL;
+        }
+        sleep_ms(1);
+    }
+
+    if (porta_local) {
+        if (!host_ponte_inicia(porta_local, SIM_PORTA)) {
+            host_encerra(1);
+            return NULL;
+        }
+        fprintf(stderr, "sim: servidor em http://127.0.0.1:%u/\n", porta_local);
+    }
+
+    if (erros > 0) codigo = testa_erros(erros);
+    if (carga_clientes > 0 && codigo == 0) codigo = testa_carga(carga_clientes);
+
+    if (num_seqs > 0 && codigo == 0) {
+        host_cliente_t *c = host_rede_conecta(SIM_PORTA);
+        uint64_t t0 = time_us_64();
+        int requisicoes = 0;
+        unsigned long comandos = 0;
+        char caminho[256];
+
+        if (!c) {
+            fprintf(stderr, "sim: conexão recusada\n");
+            host_encerra(1);
+            return NULL;
+        }
+        for (int r = 0; r < repeticoes && codigo == 0; r++) {
+            for (int i = 0; i < num_seqs; i++) {
+                snprintf(caminho, sizeof(caminho), "/cmd?seq=%s", seqs[i]);
+                int status = requisita(c, caminho, corpo, sizeof(corpo));
+                if (status != status_esperado) {
+                    fprintf(stderr, "sim: %.60s -> %d (esperava %d)\n", caminho, status, status_esperado);
+                    codigo = 1;
+                    break;
+                }
+                if (repeticoes == 1) fprintf(stderr, "%s -> %s\n", caminho, corpo);
+                requisicoes++;
+                comandos += strlen(seqs[i]);
+                if (status != 200) break;
+            }
+            if (status_esperado != 200) break;
+        }
+        uint64_t dt = time_us_64() - t0;
+        fprintf(stderr, "%d requisições em %.1f ms (%.1f us cada)\n", requisicoes, dt / 1000.0,
+                requisicoes ? (double)dt / requisicoes : 0.0);
+
+        // Cada resposta 200 só sai depois da sequência inteira executada
+        if (codigo == 0 && status_esperado == 200 && requisita(c, "/stats", corpo, sizeof(corpo)) == 200) {
+            const char *executados = strstr(corpo, "\"executados\":");
+            fprintf(stderr, "/stats -> %s\n", corpo);
+            if (!executados || strtoul(executados + 13, NULL, 10) != comandos) {
+                fprintf(stderr, "sim: %lu comandos enviados, /stats não mostra todos executados\n", comandos);
+                codigo = 1;
+            }
+        }
+        host_rede_fecha(c);
+    }
+
+    if (duracao_ms) {
+        int64_t falta = (int64_t)duracao_ms * 1000 - (int64_t)(time_us_64() - inicio);
+        if (falta > 0) sleep_us(falta);
+    } else if (num_seqs == 0 && erros == 0 && carga_clientes == 0) {
+        return NULL;   // Roda até ser interrompido
+    }
+
+    sleep_ms(20);   // O núcleo 1 desenha o último quadro
+    imprime_matriz();
+    host_encerra(codigo);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int opcao;
+    pthread_t cliente;
+
+    while ((opcao = getopt(argc, argv, "c:n:x:e:l:t:p:T:q")) != -1) {
+        switch (opcao) {
+            case 'c':
+                if (num_seqs < SIM_SEQS_MAX) seqs[num_seqs++] = optarg;
+                break;
+            case 'n':
+                repeticoes = atoi(optarg);
+                break;
+            case 'x':
+                status_esperado = atoi(optarg);
+                break;
+            case 'e':
+                erros = atoi(optarg);
+                break;
+            case 'l':
+                carga_clientes = atoi(optarg);
+                break;
+            case 't':
+                duracao_ms = strtoul(optarg, NULL, 10);
+                break;
+            case 'p':
+                porta_local = atoi(optarg);
+                break;
+            case 'T': {
+                FILE *usb = fopen(optarg, "wb");
+                if (!usb) {
+                    perror(optarg);
+                    return 1;
+                }
+                host_usb_conecta(usb);
+                host_console_envia("T");
+                break;
+            }
+            case 'q':
+                if (!freopen("/dev/null", "w", stdout)) perror("sim: /dev/null");
+                break;
+            default:
+                fprintf(stderr, "uso: %s [-c SEQ]... [-n N] [-x STATUS] [-e N] [-l N] [-t MS] [-p PORTA] [-T ARQUIVO] [-q]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    pthread_create(&cliente, NULL, cliente_laco, NULL);
+    pthread_detach(cliente);
+    return robovigia_main();
+}
@@ -0,0 +1,161 @@
+// Implementação no host do tempo e dos alarmes do pico-sdk. Os alarmes rodam numa thread
+// própria, que faz o papel da interrupção do timer: os callbacks são chamados sem nenhum lock.
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/timer.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define HOST_ALARMES 16   // Como o pool de alarmes padrão do pico-sdk
+
+typedef struct {
+    alarm_id_t id;              // 0 se livre
+    absolute_time_t quando;
+    alarm_callback_t callback;
+    void *user_data;
+} alarme_t;
+
+static alarme_t alarmes[HOST_ALARMES];
+static alarm_id_t proximo_id = 1;
+static alarm_id_t disparando;   // Alarme com o callback em andamento (cancel_alarm não o remove)
+static pthread_mutex_t alarmes_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t alarmes_cond;
+static pthread_once_t alarmes_once = PTHREAD_ONCE_INIT;
+static pthread_t alarmes_thread;
+
+static uint64_t agora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// O "boot" é a primeira consulta ao relógio
+static uint64_t boot_ns;
+static pthread_once_t boot_once = PTHREAD_ONCE_INIT;
+
+static void marca_boot(void) {
+    boot_ns = agora_ns();
+}
+
+uint64_t time_us_64(void) {
+    pthread_once(&boot_once, marca_boot);
+    return (agora_ns() - boot_ns) / 1000;
+}
+
+// Converte um momento do relógio da simulação para o CLOCK_MONOTONIC (usado pelas esperas)
+static struct timespec prazo_timespec(absolute_time_t t) {
+    int64_t falta_us = (int64_t)(t - time_us_64());
+    struct timespec ts;
+
+    if (falta_us < 0) falta_us = 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += falta_us / 1000000;
+    ts.tv_nsec += (falta_us % 1000000) * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+void sleep_until(absolute_time_t t) {
+    struct timespec ts = prazo_timespec(t);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+void sleep_us(uint64_t us) {
+    sleep_until(time_us_64() + us);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+// Thread dos alarmes: dorme até o alarme mais próximo e chama o callback fora do mutex
+static void *alarmes_laco(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&alarmes_mutex);
+    while (true) {
+        alarme_t *proximo = NULL;
+        for (int i = 0; i < HOST_ALARMES; i++) {
+            if (alarmes[i].id && (!proximo || (int64_t)(alarmes[i].quando - proximo->quando) < 0)) proximo = &alarmes[i];
+        }
+
+        if (!proximo) {
+            pthread_cond_wait(&alarmes_cond, &alarmes_mutex);
+            continue;
+        }
+        if ((int64_t)(proximo->quando - time_us_64()) > 0) {
+            struct timespec ts = prazo_timespec(proximo->quando);
+            pthread_cond_timedwait(&alarmes_cond, &alarmes_mutex, &ts);
+            continue;
+        }
+
+        alarme_t a = *proximo;
+        disparando = a.id;
+        pthread_mutex_unlock(&alarmes_mutex);
+        int64_t repete = a.callback(a.id, a.user_data);
+        pthread_mutex_lock(&alarmes_mutex);
+
+        // O callback pode ter sido cancelado (ou o slot reaproveitado) enquanto rodava
+        disparando = 0;
+        if (proximo->id != a.id) continue;
+        if (repete > 0) proximo->quando = a.quando + repete;
+        else if (repete < 0) proximo->quando = time_us_64() - repete;
+        else proximo->id = 0;
+    }
+    return NULL;
+}
+
+static void alarmes_inicia(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&alarmes_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_create(&alarmes_thread, NULL, alarmes_laco, NULL);
+}
+
+alarm_id_t add_alarm_at(absolute_time_t t, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    pthread_once(&alarmes_once, alarmes_inicia);
+
+    if ((int64_t)(t - time_us_64()) <= 0 && !fire_if_past) return 0;
+
+    pthread_mutex_lock(&alarmes_mutex);
+    alarm_id_t id = -1;
+    for (int i = 0; i < HOST_ALARMES; i++) {
+        if (alarmes[i].id) continue;
+        id = proximo_id++;
+        if (proximo_id <= 0) proximo_id = 1;
+        alarmes[i] = (alarme_t){ .id = id, .quando = t, .callback = callback, .user_data = user_data };
+        pthread_cond_signal(&alarmes_cond);
+        break;
+    }
+    pthread_mutex_unlock(&alarmes_mutex);
+    return id;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_at(time_us_64() + us, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us((uint64_t)ms * 1000, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    bool cancelado = false;
+
+    pthread_mutex_lock(&alarmes_mutex);
+    for (int i = 0; i < HOST_ALARMES; i++) {
+        if (alarmes[i].id == id && id != disparando) {
+            alarmes[i].id = 0;
+            cancelado = true;
+        }
+    }
+    pthread_mutex_unlock(&alarmes_mutex);
+    return cancelado;
+}
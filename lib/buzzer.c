@@ -3,13 +3,22 @@
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
 #include "hardware/clocks.h"  // para clock_get_hz()
+#include "temporizador.h"
 
 // Variáveis estáticas internas para controle do buzzer
 static uint buzzer_pin;            // Pino configurado para o buzzer
 static uint buzzer_repeticao = 0;
 static uint buzzer_frequencia = 0;
-static uint beep_duracao = 0;
-static uint32_t beep_end_time = 0; // Tempo (em ms) para desligar o beep
+static temporizador_t beep_temporizador; // Alterna liga/desliga a cada duração do beep
+
+// Callback do temporizador do beep: alterna o buzzer até acabarem as repetições
+static void beep_alterna(temporizador_t *t) {
+    buzzer_repeticao--;
+    if(buzzer_repeticao % 2 == 1)  buzzer_turn_on(buzzer_frequencia);
+    else buzzer_turn_off();
+
+    if (buzzer_repeticao == 0) temporizador_cancela(t);
+}
 
 // Inicializa o buzzer: configura o pino como PWM e desliga o som inicialmente
 void buzzer_init(uint pin) {
@@ -23,6 +32,8 @@ void buzzer_init(uint pin) {
     
     // Garante que o buzzer inicie desligado
     pwm_set_gpio_level(buzzer_pin, 0);
+
+    temporizador_init(&beep_temporizador, beep_alterna, NULL);
 }
 
 // Liga o buzzer com a frequência especificada
@@ -46,8 +57,9 @@ void buzzer_start(uint frequency, uint duration_ms) {
     buzzer_turn_off();
     buzzer_turn_on(frequency);
     
+    buzzer_frequencia = frequency;
     buzzer_repeticao = 1;
-    beep_end_time = to_ms_since_boot(get_absolute_time()) + duration_ms;
+    temporizador_agenda(&beep_temporizador, duration_ms, 0);
 }
 
 void beep(uint frequency, uint duration_ms, uint repeticao){
@@ -57,22 +69,12 @@ void beep(uint frequency, uint duration_ms, uint repeticao){
 
     buzzer_frequencia = frequency;
     buzzer_repeticao = (2*repeticao) - 1;
-    beep_end_time = to_ms_since_boot(get_absolute_time()) + duration_ms;
-    beep_duracao = duration_ms;
+    temporizador_agenda(&beep_temporizador, duration_ms, duration_ms);
 }
 
 // Para o beep (desliga o buzzer e zera o estado)
 void buzzer_stop(void) {
     buzzer_turn_off();
-    buzzer_repeticao--;
-}
-
-// Deve ser chamada periodicamente (ex.: no loop principal) para atualizar o estado do beep
-void buzzer_update(void) {
-    if (buzzer_repeticao > 0 && (to_ms_since_boot(get_absolute_time()) >= beep_end_time)) {
-        buzzer_repeticao--;
-        if(buzzer_repeticao % 2 == 1)  buzzer_turn_on(buzzer_frequencia);
-        else buzzer_turn_off();
-        beep_end_time = to_ms_since_boot(get_absolute_time()) + beep_duracao;
-    }
+    buzzer_repeticao = 0;
+    temporizador_cancela(&beep_temporizador);
 }
@@ -7,6 +7,9 @@
 
 
 
+// Os beeps são temporizados pela roda de lib/temporizador (temporizador_roda_init() deve ter
+// sido chamada antes dos beeps)
+
 // Inicializa o buzzer no pino especificado (usando PWM)
 void buzzer_init(uint pin);
 
@@ -25,10 +28,6 @@ void buzzer_start(uint frequency, uint duration_ms);
 // Para o beep (desliga o buzzer)
 void buzzer_stop(void);
 
-// Função de atualização: deve ser chamada periodicamente no loop principal para
-// verificar se a duração do beep expirou e desligar o buzzer
-void buzzer_update(void);
-
 
 
 
@@ -0,0 +1,127 @@
+#include "fov.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Implementação do "symmetric shadowcasting" (Albert Ford). Cada quadrante (norte, sul, leste,
+// oeste) é varrido em linhas de profundidade crescente; as sombras dos obstáculos estreitam o
+// intervalo de inclinações das linhas seguintes. Em vez de recursão, as linhas de cada
+// profundidade ficam em uma lista e a pilha fica constante. As linhas agendadas a partir de uma
+// profundidade são disjuntas, separadas por sombras de ao menos uma célula, e cada uma contém uma
+// célula livre dessa profundidade: cada linha tem uma célula própria, e uma profundidade do
+// quadrante tem no máximo (lado do mapa + 2) células contando a borda. A lista é dimensionada
+// para esse pior caso, e nenhuma linha é descartada.
+
+// Divisão inteira arredondando para baixo / para cima (den > 0)
+static inline int div_piso(int num, int den) {
+    return (num >= 0) ? num / den : -((-num + den - 1) / den);
+}
+
+static inline int div_teto(int num, int den) {
+    return (num >= 0) ? (num + den - 1) / den : -((-num) / den);
+}
+
+bool fov_init(fov_t *f, const mapa_t *m) {
+    uint16_t lado = m->largura > m->altura ? m->largura : m->altura;
+
+    f->largura = m->largura;
+    f->altura = m->altura;
+    f->palavras = ((uint32_t)m->largura * m->altura + 31) / 32;
+    f->capacidade = lado + 2;
+    f->atual = malloc(f->capacidade * sizeof(fov_linha_t));
+    f->proxima = malloc(f->capacidade * sizeof(fov_linha_t));
+
+    if (!f->atual || !f->proxima) {
+        fov_free(f);
+        return false;
+    }
+    return true;
+}
+
+void fov_free(fov_t *f) {
+    free(f->atual);
+    free(f->proxima);
+    f->atual = f->proxima = NULL;
+}
+
+static inline void marca(uint32_t *bits, const mapa_t *m, int x, int y) {
+    if (!mapa_dentro(m, x, y)) return;          // A borda de obstáculos não entra no bitmap
+    uint32_t i = (uint32_t)y * m->largura + (uint32_t)x;
+    bits[i >> 5] |= 1u << (i & 31);
+}
+
+// Varre um quadrante. (cx, cy) é o passo de coluna e (px, py) o passo de profundidade no mapa.
+static void varre_quadrante(fov_t *f, const mapa_t *m, int ox, int oy,
+                            int px, int py, int cx, int cy, uint32_t *bits) {
+    // Colunas e profundidades são limitadas ao mapa mais a borda, que é lida como obstáculo
+    int col_min, col_max, prof_max;
+    if (cx) {
+        col_min = cx > 0 ? -1 - ox : ox - m->largura;
+        col_max = cx > 0 ? m->largura - ox : ox + 1;
+        prof_max = py > 0 ? m->altura - oy : oy + 1;
+    } else {
+        col_min = cy > 0 ? -1 - oy : oy - m->altura;
+        col_max = cy > 0 ? m->altura - oy : oy + 1;
+        prof_max = px > 0 ? m->largura - ox : ox + 1;
+    }
+
+    uint16_t n_atual = 1, n_proxima;
+    f->atual[0] = (fov_linha_t){ -1, 1, 1, 1 };
+
+    for (int prof = 1; prof <= prof_max && n_atual; prof++) {
+        n_proxima = 0;
+
+        for (uint16_t l = 0; l < n_atual; l++) {
+            fov_linha_t linha = f->atual[l];
+
+            // Colunas cobertas pela linha (arredondamento com empate para o centro da célula)
+            int c_ini = div_piso(2 * prof * linha.ini_num + linha.ini_den, 2 * linha.ini_den);
+            int c_fim = div_teto(2 * prof * linha.fim_num - linha.fim_den, 2 * linha.fim_den);
+            if (c_ini < col_min) c_ini = col_min;
+            if (c_fim > col_max) c_fim = col_max;
+
+            int anterior = -1;                   // -1: nenhuma célula, 0: livre, 1: obstáculo
+            for (int c = c_ini; c <= c_fim; c++) {
+                int x = ox + px * prof + cx * c;
+                int y = oy + py * prof + cy * c;
+                int parede = mapa_get(m, x, y) == OBSTACULO;
+
+                // Obstáculos alcançados são visíveis; células livres só se a visão for simétrica
+                if (parede ||
+                    ((int32_t)c * linha.ini_den >= (int32_t)prof * linha.ini_num &&
+                     (int32_t)c * linha.fim_den <= (int32_t)prof * linha.fim_num)) {
+                    marca(bits, m, x, y);
+                }
+
+                if (anterior == 1 && !parede) {
+                    // Fim de uma sombra: a próxima linha começa na borda esquerda desta célula
+                    linha.ini_num = 2 * c - 1;
+                    linha.ini_den = 2 * prof;
+                }
+                if (anterior == 0 && parede) {
+                    // Início de uma sombra: fecha a parte livre e a agenda para a próxima profundidade
+                    f->proxima[n_proxima++] = (fov_linha_t){ linha.ini_num, linha.ini_den, 2 * c - 1, 2 * prof };
+                }
+                anterior = parede;
+            }
+            if (anterior == 0) {
+                f->proxima[n_proxima++] = linha;
+            }
+        }
+
+        fov_linha_t *tmp = f->atual;
+        f->atual = f->proxima;
+        f->proxima = tmp;
+        n_atual = n_proxima;
+    }
+}
+
+void fov_calcula(fov_t *f, const mapa_t *m, int x, int y, uint32_t *bits) {
+    memset(bits, 0, f->palavras * sizeof(uint32_t));
+    marca(bits, m, x, y);
+
+    varre_quadrante(f, m, x, y,  0, -1, 1, 0, bits);   // Norte
+    varre_quadrante(f, m, x, y,  0,  1, 1, 0, bits);   // Sul
+    varre_quadrante(f, m, x, y,  1,  0, 0, 1, bits);   // Leste
+    varre_quadrante(f, m, x, y, -1,  0, 0, 1, bits);   // Oeste
+}
@@ -0,0 +1,39 @@
+#ifndef FOV_H
+#define FOV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mapa.h"
+
+// Linha de varredura de um quadrante: inclinações inicial e final como frações (num/den, den > 0)
+typedef struct {
+    int16_t ini_num, ini_den;
+    int16_t fim_num, fim_den;
+} fov_linha_t;
+
+// Área de trabalho do cálculo de campo de visão (alocada uma vez por mapa)
+typedef struct {
+    uint16_t largura, altura;
+    uint16_t palavras;           // Palavras de 32 bits por bitmap de visibilidade
+    uint16_t capacidade;         // Linhas pendentes por profundidade no pior caso (lado + 2)
+    fov_linha_t *atual, *proxima;
+} fov_t;
+
+// Prepara a área de trabalho para mapas com as dimensões de m. Retorna false se faltar memória.
+bool fov_init(fov_t *f, const mapa_t *m);
+
+// Libera a área de trabalho
+void fov_free(fov_t *f);
+
+// Calcula todas as células visíveis a partir de (x, y) com shadowcasting simétrico, em uma única
+// varredura O(células). O resultado vai para bits (f->palavras palavras), bit (y * largura + x).
+// Obstáculos são marcados quando alcançados pela varredura.
+void fov_calcula(fov_t *f, const mapa_t *m, int x, int y, uint32_t *bits);
+
+// Consulta uma célula em um bitmap de visibilidade
+static inline bool fov_visivel(const uint32_t *bits, const mapa_t *m, int x, int y) {
+    uint32_t i = (uint32_t)y * m->largura + (uint32_t)x;
+    return (bits[i >> 5] >> (i & 31)) & 1u;
+}
+
+#endif // FOV_H
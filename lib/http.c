@@ -0,0 +1,230 @@
+#include "http.h"
+
+#include <string.h>
+
+enum {
+    E_METODO,    // "MÉTODO " reconhecido contra a tabela de rotas
+    E_CAMINHO,   // "/caminho", idem, até o espaço ou '?'
+    E_QUERY,     // Após '?', até o espaço
+    E_VERSAO,    // "HTTP/1.x" até o fim da linha
+    E_NOME,      // Nome de um cabeçalho, até ':'
+    E_VALOR,     // Valor do cabeçalho, até o fim da linha
+    E_CORPO      // Corpo (Content-Length) descartado
+};
+
+// Cabeçalhos que interessam ao servidor, em minúsculas e em ordem crescente
+enum { CAB_CONNECTION, CAB_CONTENT_LENGTH, CAB_WS_CHAVE, CAB_NENHUM };
+static const char *const cabecalhos[] = { "connection", "content-length", "sec-websocket-key" };
+#define NUM_CABECALHOS (sizeof(cabecalhos) / sizeof(cabecalhos[0]))
+
+#define CORPO_MAX 100000000u       // Content-Length aceito (o corpo é só descartado)
+#define TOKEN_CLOSE 1
+#define TOKEN_KEEP_ALIVE 2
+
+static inline char minuscula(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// Restringe a faixa [lo, hi) de uma tabela ordenada às chaves com o caractere c na posição pos.
+// Como todas as chaves da faixa têm o mesmo prefixo até pos, as que casam são contíguas: é
+// uma trie implícita sobre a própria tabela, sem nós a montar. Chaves mais curtas saem da
+// faixa no seu '\0', então nunca se lê além do fim de uma chave. Por isso c não pode ser '\0'
+// (casaria com o fim da chave): quem chama recusa o '\0' antes.
+#define ESTREITA(lo, hi, chave, pos, c)                                 \
+    do {                                                                \
+        while ((lo) < (hi) && (chave((lo)))[pos] != (c)) (lo)++;        \
+        uint8_t fim_ = (lo);                                            \
+        while (fim_ < (hi) && (chave(fim_))[pos] == (c)) fim_++;        \
+        (hi) = fim_;                                                    \
+    } while (0)
+
+#define CHAVE_ROTA(i) (p->rotas[i].chave)
+#define CHAVE_CABECALHO(i) (cabecalhos[i])
+
+void http_parser_init(http_parser_t *p, const http_rota_t *rotas, uint8_t num_rotas) {
+    p->rotas = rotas;
+    p->num_rotas = num_rotas;
+    http_parser_reinicia(p);
+}
+
+void http_parser_reinicia(http_parser_t *p) {
+    p->estado = E_METODO;
+    p->lo = 0;
+    p->hi = p->num_rotas;
+    p->pos = 0;
+    p->lidos = 0;
+    p->corpo = 0;
+    p->rota = -1;
+    p->http10 = false;
+    p->conexao_close = false;
+    p->conexao_keep_alive = false;
+    p->query_tam = 0;
+    p->query_cortada = false;
+    p->ws_chave_tam = 0;
+    p->query[0] = '\0';
+    p->ws_chave[0] = '\0';
+}
+
+// Casa o valor de Connection token a token ("keep-alive, Upgrade"); c == 0 encerra o valor
+static void connection_token(http_parser_t *p, char c) {
+    static const char close[] = "close";
+    static const char keep_alive[] = "keep-alive";
+
+    if (c == ',' || c == ' ' || c == '\t' || c == 0) {
+        if ((p->token & TOKEN_CLOSE) && p->pos == sizeof(close) - 1) p->conexao_close = true;
+        if ((p->token & TOKEN_KEEP_ALIVE) && p->pos == sizeof(keep_alive) - 1) p->conexao_keep_alive = true;
+        p->token = TOKEN_CLOSE | TOKEN_KEEP_ALIVE;
+        p->pos = 0;
+        return;
+    }
+
+    c = minuscula(c);
+    if (p->pos >= sizeof(close) - 1 || close[p->pos] != c) p->token &= ~TOKEN_CLOSE;
+    if (p->pos >= sizeof(keep_alive) - 1 || keep_alive[p->pos] != c) p->token &= ~TOKEN_KEEP_ALIVE;
+    if (p->token) p->pos++;
+}
+
+// Encerra o valor de um cabeçalho e prepara a leitura do próximo nome
+static void fim_valor(http_parser_t *p) {
+    if (p->cabecalho == CAB_CONNECTION) connection_token(p, 0);
+    if (p->cabecalho == CAB_WS_CHAVE) {
+        while (p->ws_chave_tam > 0 && p->ws_chave[p->ws_chave_tam - 1] == ' ') p->ws_chave_tam--;
+        p->ws_chave[p->ws_chave_tam] = '\0';
+    }
+    p->estado = E_NOME;
+    p->lo = 0;
+    p->hi = NUM_CABECALHOS;
+    p->pos = 0;
+}
+
+http_resultado_t http_parser_alimenta(http_parser_t *p, const char *dados, size_t tam, size_t *consumidos) {
+    size_t i = 0;
+    http_resultado_t r = HTTP_INCOMPLETA;
+
+    while (i < tam && r == HTTP_INCOMPLETA) {
+        if (p->estado == E_CORPO) {
+            size_t n = tam - i < p->corpo ? tam - i : p->corpo;
+            i += n;
+            p->corpo -= n;
+            if (p->corpo == 0) r = HTTP_COMPLETA;
+            continue;
+        }
+
+        // Cabeçalhos que não interessam (a maior parte da requisição) são pulados de uma vez:
+        // o nome até o ':' e o valor até o fim da linha. O nome também para no '\n', que o
+        // caminho lento trata como linha sem ':'.
+        bool nome = p->estado == E_NOME && p->lo >= p->hi && p->pos > 0;
+        if (nome || (p->estado == E_VALOR && p->cabecalho == CAB_NENHUM)) {
+            const char *fim;
+            if (nome) {
+                size_t j = i;
+                while (j < tam && dados[j] != ':' && dados[j] != '\n') j++;
+                fim = j < tam ? dados + j : NULL;
+            } else {
+                fim = memchr(dados + i, '\n', tam - i);
+            }
+            size_t n = fim ? (size_t)(fim - (dados + i)) : tam - i;
+            i += n;
+            p->lidos += n;
+            if (p->lidos > HTTP_CABECALHOS_MAX) {
+                r = HTTP_GRANDE;
+                break;
+            }
+            if (!fim) continue;
+        }
+
+        char c = dados[i++];
+        if (++p->lidos > HTTP_CABECALHOS_MAX) {
+            r = HTTP_GRANDE;
+            break;
+        }
+        if (c == '\r') continue;   // Os fins de linha são reconhecidos pelo '\n'
+
+        switch (p->estado) {
+        case E_METODO:
+            // O espaço depois do método faz parte da chave ("GET /up")
+            if (c == '\n' || c == '\0') { r = HTTP_ERRO; break; }
+            ESTREITA(p->lo, p->hi, CHAVE_ROTA, p->pos, c);
+            p->pos++;
+            if (c == ' ') p->estado = E_CAMINHO;
+            break;
+
+        case E_CAMINHO:
+            if (c == '\n' || c == '\0') { r = HTTP_ERRO; break; }
+            if (c == ' ' || c == '?') {
+                if (p->lo < p->hi && CHAVE_ROTA(p->lo)[p->pos] == '\0') p->rota = p->lo;
+                p->estado = (c == '?') ? E_QUERY : E_VERSAO;
+                p->pos = 0;
+                break;
+            }
+            ESTREITA(p->lo, p->hi, CHAVE_ROTA, p->pos, c);
+            if (p->pos < UINT16_MAX) p->pos++;
+            break;
+
+        case E_QUERY:
+            if (c == '\n') { r = HTTP_ERRO; break; }
+            if (c == ' ') {
+                p->estado = E_VERSAO;
+                p->pos = 0;
+            } else if (p->query_tam < HTTP_QUERY_MAX) {
+                p->query[p->query_tam++] = c;
+                p->query[p->query_tam] = '\0';
+            } else {
+                p->query_cortada = true;
+            }
+            break;
+
+        case E_VERSAO:
+            if (c == '\n') {
+                if (p->pos < 8) { r = HTTP_ERRO; break; }
+                fim_valor(p);   // Sem cabeçalho anterior: só prepara a leitura dos nomes
+                break;
+            }
+            if (p->pos < 7 && "HTTP/1."[p->pos] != c) { r = HTTP_ERRO; break; }
+            if (p->pos == 7) p->http10 = (c == '0');
+            if (p->pos < UINT16_MAX) p->pos++;
+            break;
+
+        case E_NOME:
+            if (c == '\n') {
+                if (p->pos > 0) { r = HTTP_ERRO; break; }   // Linha de cabeçalho sem ':'
+                // Linha vazia: fim dos cabeçalhos
+                if (p->corpo > 0) p->estado = E_CORPO;
+                else r = HTTP_COMPLETA;
+                break;
+            }
+            if (c == ':') {
+                p->cabecalho = (p->lo < p->hi && cabecalhos[p->lo][p->pos] == '\0') ? p->lo : CAB_NENHUM;
+                p->estado = E_VALOR;
+                p->token = TOKEN_CLOSE | TOKEN_KEEP_ALIVE;
+                p->pos = 0;
+                break;
+            }
+            if (c == '\0') { r = HTTP_ERRO; break; }
+            c = minuscula(c);
+            ESTREITA(p->lo, p->hi, CHAVE_CABECALHO, p->pos, c);
+            if (p->pos < UINT16_MAX) p->pos++;
+            break;
+
+        case E_VALOR:
+            if (c == '\n') {
+                fim_valor(p);
+                break;
+            }
+            if (p->cabecalho == CAB_CONNECTION) {
+                connection_token(p, c);
+            } else if (p->cabecalho == CAB_CONTENT_LENGTH) {
+                if (c == ' ' || c == '\t') break;
+                if (c < '0' || c > '9' || p->corpo > CORPO_MAX / 10) { r = HTTP_ERRO; break; }
+                p->corpo = p->corpo * 10 + (c - '0');
+            } else if (p->cabecalho == CAB_WS_CHAVE) {
+                if (p->ws_chave_tam == 0 && (c == ' ' || c == '\t')) break;
+                if (p->ws_chave_tam < HTTP_WS_CHAVE_MAX) p->ws_chave[p->ws_chave_tam++] = c;
+            }
+            break;
+        }
+    }
+
+    *consumidos = i;
+    return r;
+}
@@ -0,0 +1,71 @@
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Parser incremental de requisições HTTP/1.x. Recebe os bytes em pedaços de qualquer tamanho
+// (por exemplo, cada pbuf de uma cadeia) sem copiá-los: a rota é reconhecida byte a byte contra
+// uma tabela ordenada, e apenas os poucos valores que interessam (query, Sec-WebSocket-Key)
+// são guardados no estado do parser.
+
+#define HTTP_QUERY_MAX 160         // Bytes guardados da query string (após '?'); até 255
+#define HTTP_WS_CHAVE_MAX 32       // Bytes guardados do Sec-WebSocket-Key
+#define HTTP_CABECALHOS_MAX 4096   // Tamanho máximo da linha de requisição + cabeçalhos
+
+// Rota: "MÉTODO /caminho" e um identificador livre para o chamador. A tabela deve estar em
+// ordem crescente de chave (strcmp), o que permite reconhecer a rota sem guardar o caminho.
+typedef struct {
+    const char *chave;
+    int id;
+} http_rota_t;
+
+typedef enum {
+    HTTP_INCOMPLETA,   // Todos os bytes foram consumidos e a requisição ainda não terminou
+    HTTP_COMPLETA,     // Uma requisição terminou; os bytes seguintes são da próxima
+    HTTP_ERRO,         // Requisição malformada
+    HTTP_GRANDE        // Cabeçalhos maiores que HTTP_CABECALHOS_MAX
+} http_resultado_t;
+
+typedef struct {
+    const http_rota_t *rotas;
+    uint8_t num_rotas;
+
+    // Estado interno
+    uint8_t estado;
+    uint8_t lo, hi;            // Faixa de rotas (ou cabeçalhos) que ainda casam com o que foi lido
+    uint8_t cabecalho;         // Cabeçalho conhecido cujo valor está sendo lido
+    uint8_t token;             // Connection: o token atual ainda pode ser close (1) / keep-alive (2)
+    uint16_t pos;              // Posição dentro do token atual
+    uint16_t lidos;            // Bytes de linha de requisição + cabeçalhos
+    uint32_t corpo;            // Bytes de corpo ainda a descartar
+
+    // Resultado (válido após HTTP_COMPLETA)
+    int rota;                  // Índice na tabela, ou -1
+    bool http10;
+    bool conexao_close;        // "Connection: close"
+    bool conexao_keep_alive;   // "Connection: keep-alive"
+    uint8_t query_tam;
+    bool query_cortada;        // A query passou de HTTP_QUERY_MAX bytes: query tem só o começo
+    uint8_t ws_chave_tam;
+    char query[HTTP_QUERY_MAX + 1];
+    char ws_chave[HTTP_WS_CHAVE_MAX + 1];
+} http_parser_t;
+
+void http_parser_init(http_parser_t *p, const http_rota_t *rotas, uint8_t num_rotas);
+
+// Prepara o parser para a próxima requisição da mesma conexão
+void http_parser_reinicia(http_parser_t *p);
+
+// Consome bytes até terminar uma requisição ou acabarem os dados; *consumidos recebe quantos
+// bytes foram usados. Com HTTP_COMPLETA o chamador responde, chama http_parser_reinicia e
+// continua com o restante (requisições encadeadas).
+http_resultado_t http_parser_alimenta(http_parser_t *p, const char *dados, size_t tam, size_t *consumidos);
+
+// A conexão deve ser fechada após a resposta (HTTP/1.1: só com close; HTTP/1.0: sem keep-alive)
+static inline bool http_fecha_apos(const http_parser_t *p) {
+    return p->http10 ? !p->conexao_keep_alive : p->conexao_close;
+}
+
+#endif // HTTP_H
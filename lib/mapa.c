@@ -0,0 +1,103 @@
+#include "mapa.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Escreve uma célula na posição armazenada i (já considerando a borda)
+static inline void escreve_celula(mapa_t *m, uint32_t i, uint8_t valor) {
+    uint8_t deslocamento = (i & 1) << 2;
+    m->celulas[i >> 1] = (m->celulas[i >> 1] & ~(0x0F << deslocamento)) | ((valor & 0x0F) << deslocamento);
+}
+
+bool mapa_init(mapa_t *m, uint16_t largura, uint16_t altura) {
+    if (largura == 0 || altura == 0 || largura > MAPA_MAX || altura > MAPA_MAX) return false;
+
+    uint32_t passo = largura + 2;
+    uint32_t total = passo * (altura + 2);        // Células armazenadas, incluindo a borda
+
+    m->celulas = calloc((total + 1) / 2, sizeof(uint8_t));
+    if (!m->celulas) return false;
+
+    m->largura = largura;
+    m->altura = altura;
+    m->passo = passo;
+    m->versao_obstaculos = 1;
+    m->versao_celulas = 1;
+
+    // Cerca o mapa com obstáculos: linhas de cima e de baixo, depois as colunas laterais
+    for (uint32_t x = 0; x < passo; x++) {
+        escreve_celula(m, x, OBSTACULO);
+        escreve_celula(m, (altura + 1) * passo + x, OBSTACULO);
+    }
+    for (uint32_t y = 1; y <= altura; y++) {
+        escreve_celula(m, y * passo, OBSTACULO);
+        escreve_celula(m, y * passo + largura + 1, OBSTACULO);
+    }
+    return true;
+}
+
+void mapa_free(mapa_t *m) {
+    free(m->celulas);
+    m->celulas = NULL;
+    m->largura = m->altura = 0;
+}
+
+bool mapa_carrega(mapa_t *m, const uint8_t *layout, uint16_t largura, uint16_t altura) {
+    if (!mapa_init(m, largura, altura)) return false;
+
+    for (int y = 0; y < altura; y++) {
+        for (int x = 0; x < largura; x++) {
+            mapa_set(m, x, y, layout[y * largura + x]);
+        }
+    }
+    return true;
+}
+
+void mapa_set(mapa_t *m, int x, int y, uint8_t valor) {
+    if (mapa_get(m, x, y) == OBSTACULO || valor == OBSTACULO) {
+        m->versao_obstaculos++;          // Invalida as visibilidades calculadas anteriormente
+        if (m->versao_obstaculos == 0) m->versao_obstaculos = 1;
+    }
+    if (++m->versao_celulas == 0) m->versao_celulas = 1;
+    escreve_celula(m, (uint32_t)(y + 1) * m->passo + (uint32_t)(x + 1), valor);
+}
+
+// Função para tentar criar uma linha entre 2 pontos e detectar se há um obstáculos entre eles
+bool mapa_tem_obstaculo_entre(const mapa_t *m, int x1, int y1, int x2, int y2) {
+     // Calcula as diferenças absolutas entre os pontos
+    int dx = abs(x2 - x1);
+    int dy = abs(y2 - y1);
+
+    // Define o sentido do deslocamento nos eixos X e Y
+    int sx = x1 < x2 ? 1 : -1;  // Se x2 > x1, anda para direita; senão, esquerda
+    int sy = y1 < y2 ? 1 : -1;  // Se y2 > y1, anda para baixo; senão, cima
+
+    // Inicializa o erro da linha (diferença entre os eixos)
+    int err = dx - dy;
+
+    while (true) {
+        // Verifica obstáculo antes de qualquer movimento
+        if (mapa_get(m, x1, y1) == OBSTACULO) return true; // Retorna verdadeiro se houver um obstaculo
+
+        // Se cheguei no ponto final, paro
+        if (x1 == x2 && y1 == y2) break;
+
+        // Calcula erro acumulado
+        int e2 = 2 * err;
+
+        // Decide se move no eixo X
+        if (e2 > -dy) {
+            err -= dy;
+            x1 += sx;
+        }
+
+        // Decide se move no eixo Y
+        if (e2 < dx) {
+            err += dx;
+            y1 += sy;
+        }
+    }
+
+    // Não encontrou obstáculo no caminho
+    return false;
+}
@@ -0,0 +1,58 @@
+#ifndef MAPA_H
+#define MAPA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Conteúdo das células (cabe em 4 bits)
+#define VAZIO      0
+#define MAQUINA_1  1
+#define MAQUINA_2  2
+#define INTRUSO    3
+#define OBSTACULO  9
+
+#define COMBUSTIVEL_1 4 // Combustivel relativo a máquina 1
+#define COMBUSTIVEL_2 5 // Combustivel relativo a máquina 2
+
+// Maior lado de mapa suportado
+#define MAPA_MAX 256
+
+// Mapa da fábrica com dimensões definidas em tempo de execução.
+// Cada célula ocupa 4 bits e o mapa é cercado por uma borda de OBSTACULO, de modo que
+// vizinhos e passos de uma célula válida podem ser lidos sem verificação de limites.
+typedef struct {
+    uint16_t largura, altura;
+    uint16_t passo;               // Células por linha armazenada (largura + 2 da borda)
+    uint8_t *celulas;             // Duas células por byte, incluindo a borda
+    uint32_t versao_obstaculos;   // Incrementada sempre que um obstáculo aparece ou some
+    uint32_t versao_celulas;      // Incrementada a cada alteração de célula
+} mapa_t;
+
+// Aloca um mapa vazio de largura x altura (1..MAPA_MAX). Retorna false se falhar.
+bool mapa_init(mapa_t *m, uint16_t largura, uint16_t altura);
+
+// Libera a memória do mapa
+void mapa_free(mapa_t *m);
+
+// Aloca o mapa e copia um layout de largura x altura bytes (uma célula por byte, linha a linha)
+bool mapa_carrega(mapa_t *m, const uint8_t *layout, uint16_t largura, uint16_t altura);
+
+// Altera uma célula, mantendo a versão dos obstáculos coerente
+void mapa_set(mapa_t *m, int x, int y, uint8_t valor);
+
+// Verifica se (x, y) pertence ao mapa
+static inline bool mapa_dentro(const mapa_t *m, int x, int y) {
+    return (unsigned)x < m->largura && (unsigned)y < m->altura;
+}
+
+// Lê uma célula sem verificação de limites. Válido para -1 <= x <= largura e -1 <= y <= altura,
+// sendo que as posições fora do mapa retornam OBSTACULO (borda).
+static inline uint8_t mapa_get(const mapa_t *m, int x, int y) {
+    uint32_t i = (uint32_t)(y + 1) * m->passo + (uint32_t)(x + 1);
+    return (m->celulas[i >> 1] >> ((i & 1) << 2)) & 0x0F;
+}
+
+// Traça uma linha (Bresenham) entre dois pontos do mapa e detecta se há um obstáculo nela
+bool mapa_tem_obstaculo_entre(const mapa_t *m, int x1, int y1, int x2, int y2);
+
+#endif // MAPA_H
@@ -0,0 +1,64 @@
+#include "metricas.h"
+
+#include <stdio.h>
+
+// Limites superiores das faixas em µs, de 10 µs (um npWrite) a 100 ms (uma página com a
+// janela TCP cheia); a última faixa (+Inf) não tem limite
+static const uint32_t limites_us[METRICAS_FAIXAS - 1] = {
+    10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000,
+};
+
+void histograma_registra(histograma_t *h, uint32_t us) {
+    int i = 0;
+    while (i < METRICAS_FAIXAS - 1 && us > limites_us[i]) i++;
+
+    h->faixas[i]++;
+    h->soma_us += us;
+    h->total++;
+}
+
+// Resultado do snprintf limitado ao buffer (uma linha cortada ainda termina em '\n')
+static int limita(char *buf, size_t tam, int n) {
+    if (n < 0) return 0;
+    if ((size_t)n >= tam) {
+        n = tam - 1;
+        buf[n - 1] = '\n';
+    }
+    return n;
+}
+
+int histograma_linha(char *buf, size_t tam, const char *nome, const char *rotulos, const histograma_t *h, int linha) {
+    const char *sep = rotulos ? "," : "";
+    if (!rotulos) rotulos = "";
+
+    if (linha < METRICAS_FAIXAS) {
+        uint32_t acumulado = 0;
+        for (int i = 0; i <= linha; i++) acumulado += h->faixas[i];
+
+        if (linha == METRICAS_FAIXAS - 1) {
+            return limita(buf, tam, snprintf(buf, tam, "%s_bucket{%s%sle=\"+Inf\"} %lu\n", nome, rotulos, sep,
+                                             (unsigned long)acumulado));
+        }
+        uint32_t us = limites_us[linha];
+        return limita(buf, tam, snprintf(buf, tam, "%s_bucket{%s%sle=\"%lu.%06lu\"} %lu\n", nome, rotulos, sep,
+                                         (unsigned long)(us / 1000000), (unsigned long)(us % 1000000),
+                                         (unsigned long)acumulado));
+    }
+
+    const char *abre = *rotulos ? "{" : "", *fecha = *rotulos ? "}" : "";
+    if (linha == METRICAS_FAIXAS) {
+        return limita(buf, tam, snprintf(buf, tam, "%s_sum%s%s%s %lu.%06lu\n", nome, abre, rotulos, fecha,
+                                         (unsigned long)(h->soma_us / 1000000), (unsigned long)(h->soma_us % 1000000)));
+    }
+    if (linha == METRICAS_FAIXAS + 1) {
+        return limita(buf, tam, snprintf(buf, tam, "%s_count%s%s%s %lu\n", nome, abre, rotulos, fecha,
+                                         (unsigned long)h->total));
+    }
+    return 0;
+}
+
+int metricas_cabecalho(char *buf, size_t tam, const char *nome, const char *tipo, const char *ajuda, int linha) {
+    if (linha == 0) return limita(buf, tam, snprintf(buf, tam, "# HELP %s %s\n", nome, ajuda));
+    if (linha == 1) return limita(buf, tam, snprintf(buf, tam, "# TYPE %s %s\n", nome, tipo));
+    return 0;
+}
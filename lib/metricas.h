@@ -0,0 +1,37 @@
+#ifndef METRICAS_H
+#define METRICAS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Histogramas de tempo (em µs, com as mesmas faixas fixas para todos) para o /metrics, no
+// formato de texto do Prometheus. Registrar uma amostra é só uma busca em 12 limites e três
+// somas, então pode ser feito nos caminhos quentes dos dois núcleos.
+//
+// Cada histograma deve ter um único escritor (um núcleo, ou o contexto do lwIP). O leitor copia
+// os contadores sem lock: uma cópia no meio de um registro pode ver a amostra na faixa e ainda
+// não no total, o que some na cópia seguinte.
+
+#define METRICAS_FAIXAS 13                      // 12 limites e a faixa +Inf
+#define HISTOGRAMA_LINHAS (METRICAS_FAIXAS + 2) // Linhas _bucket, _sum e _count
+#define METRICAS_LINHA_MAX 256                  // Maior linha gerada, com o '\n'
+
+typedef struct {
+    uint32_t faixas[METRICAS_FAIXAS];   // Amostras em cada faixa (não acumuladas)
+    uint32_t total;
+    uint64_t soma_us;
+} histograma_t;
+
+void histograma_registra(histograma_t *h, uint32_t us);
+
+// Escreve em buf a linha `linha` (0 a HISTOGRAMA_LINHAS - 1) da série do histograma, terminada
+// em '\n': as faixas acumuladas (nome_bucket{...,le="..."}), a soma em segundos (nome_sum) e o
+// total (nome_count). rotulos é NULL ou a lista de rótulos da série sem as chaves, por exemplo
+// "rota=\"/cmd\"". Retorna o tamanho, ou 0 se linha estiver fora do histograma.
+int histograma_linha(char *buf, size_t tam, const char *nome, const char *rotulos, const histograma_t *h, int linha);
+
+// Escreve a linha 0 (# HELP) ou 1 (# TYPE) do cabeçalho de uma família de métricas
+int metricas_cabecalho(char *buf, size_t tam, const char *nome, const char *tipo, const char *ajuda, int linha);
+
+#endif // METRICAS_H
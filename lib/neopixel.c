@@ -2,7 +2,11 @@
 #include "ws2812b.pio.h" // Biblioteca gerada pelo arquivo .pio durante compilação.
 #include <stdio.h>
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "pico/stdlib.h"
+#include "trace.h"
 
 
 // Buffer de pixels que formam a matriz.
@@ -13,16 +17,96 @@ PIO np_pio = pio0;
 uint sm;
 uint32_t np_led_value;
 
+// Último quadro enviado (já codificado), para evitar reenviar quadros e pixels iguais.
+static uint32_t np_sent[LED_COUNT];
+static bool np_sent_valid = false;
+
+// Saída por DMA: o canal lê um dos buffers (frente) enquanto o outro (fundo) recebe o próximo
+// quadro. A DMA é ritmada pelo DREQ de TX da máquina PIO.
+static uint32_t np_buffers[2][LED_COUNT];
+static int np_dma_chan;
+static volatile uint np_front = 0;               // Buffer lido pela DMA no último envio
+static volatile uint np_pending_len = 0;         // Pixels do quadro no fundo à espera (0 = nenhum)
+static volatile bool np_busy = false;            // Envio ou tempo de latch em andamento
+static void (*np_write_callback)(void) = NULL;
+
+// npWrite() pode ser chamada de um núcleo enquanto as interrupções da DMA e do latch rodam no
+// outro: desabilitar interrupções não basta, então o estado acima é protegido por um spin lock
+static spin_lock_t *np_lock;
+
+// Estatísticas de envios evitados.
+static uint32_t np_suppressed_frames = 0;
+static uint32_t np_skipped_pixels = 0;
+
+
+/**
+ * Inicia a DMA com o quadro que está no buffer de fundo, que passa a ser a frente.
+ * Deve ser chamada com np_lock.
+ */
+static void np_start_pending() {
+    uint len = np_pending_len;
+    np_pending_len = 0;
+    np_front ^= 1;
+    np_busy = true;
+    trace_registra(TRACE_FLUSH_INICIO, TRACE_SAIDA_MATRIZ);
+    dma_channel_transfer_from_buffer_now(np_dma_chan, np_buffers[np_front], len);
+}
+
+/**
+ * Fim do tempo de latch: envia o quadro em espera ou avisa que a saída está livre.
+ */
+static int64_t np_latch_done(alarm_id_t id, void *user_data) {
+    bool livre = false;
+    trace_registra(TRACE_FLUSH_FIM, TRACE_SAIDA_MATRIZ);
+    uint32_t irq = spin_lock_blocking(np_lock);
+    if (np_pending_len) {
+        np_start_pending();
+    } else {
+        np_busy = false;
+        livre = true;
+    }
+    spin_unlock(np_lock, irq);
+
+    if (livre && np_write_callback) np_write_callback();
+    return 0;
+}
+
+/**
+ * Fim da DMA: a última palavra ainda está na FIFO da PIO, então espera ela esvaziar e o
+ * tempo de reset dos LEDs antes de liberar a saída.
+ */
+static void np_dma_handler() {
+    if (!dma_channel_get_irq0_status(np_dma_chan)) return;
+    dma_channel_acknowledge_irq0(np_dma_chan);
+    if (add_alarm_in_us(NP_FIFO_DRAIN_US + NP_RESET_US, np_latch_done, NULL, true) < 0) {
+        np_latch_done(0, NULL);   // Sem alarmes livres: libera a saída sem esperar o latch
+    }
+}
 
 /**
  * Inicializa a máquina PIO para controle da matriz de LEDs.
  */
 void npInit(uint pin) {
 
+    np_lock = spin_lock_instance(spin_lock_claim_unused(true));
+
     uint offset = pio_add_program(pio0, &ws2812b_program);
     sm = pio_claim_unused_sm(pio0, true);
     ws2812b_program_init(pio0, sm, offset, LED_PIN);
 
+    // Canal de DMA que alimenta a FIFO de TX da máquina PIO.
+    np_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(np_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(np_pio, sm, true));
+    dma_channel_configure(np_dma_chan, &c, &np_pio->txf[sm], np_buffers[0], LED_COUNT, false);
+
+    dma_channel_set_irq0_enabled(np_dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_0, np_dma_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
     // Limpa buffer de pixels.
     for (uint i = 0; i < LED_COUNT; ++i) {
         leds[i].R = 0;
@@ -65,14 +149,77 @@ uint32_t encode_rgb(npLED_t cor){
 
 /**
  * Escreve os dados do buffer nos LEDs.
+ *
+ * O quadro é comparado com o último enviado: se for igual, nada é enviado. Caso contrário, só
+ * é enviado até o último pixel que mudou, pois os LEDs depois dele na cadeia não recebem dados
+ * e mantêm a cor atual.
+ *
+ * Não bloqueia: o quadro codificado vai para o buffer de fundo e a DMA o envia assim que o
+ * anterior terminar. Um quadro novo substitui um que ainda esteja esperando.
  */
 void npWrite() {
+    uint32_t frame[LED_COUNT];
+    int last_changed = np_sent_valid ? -1 : LED_COUNT - 1;
 
-    // Escreve cada dado de 8-bits dos pixels em sequência no buffer da máquina PIO.
     for (uint i = 0; i < LED_COUNT; ++i) {
-        uint32_t np_led_value = encode_rgb(leds[i]);
-        pio_sm_put_blocking(np_pio, sm, np_led_value);
+        frame[i] = encode_rgb(leds[i]);
+        if (frame[i] != np_sent[i]) last_changed = i;
     }
+
+    if (last_changed < 0) {
+        np_suppressed_frames++;
+        return;
+    }
+
+    // Retira o quadro em espera (se houver) para que a interrupção não o inicie durante a cópia;
+    // as mudanças dele ainda não enviadas continuam valendo para o novo quadro.
+    uint32_t irq = spin_lock_blocking(np_lock);
+    uint len = np_pending_len;
+    np_pending_len = 0;
+    spin_unlock(np_lock, irq);
+
+    if (len < (uint)last_changed + 1) len = last_changed + 1;
+    np_skipped_pixels += LED_COUNT - len;
+
+    uint32_t *back = np_buffers[np_front ^ 1];
+    for (uint i = 0; i < len; ++i) {
+        back[i] = frame[i];
+        np_sent[i] = frame[i];
+    }
+    np_sent_valid = true;
+
+    irq = spin_lock_blocking(np_lock);
+    np_pending_len = len;
+    if (!np_busy) np_start_pending();
+    spin_unlock(np_lock, irq);
+}
+
+/**
+ * Indica se ainda há um quadro sendo enviado ou esperando para ser enviado.
+ */
+bool npWriteBusy() {
+    return np_busy;
+}
+
+/**
+ * Define uma função chamada (em contexto de interrupção) quando o último quadro pedido termina.
+ */
+void npSetWriteCallback(void (*callback)(void)) {
+    np_write_callback = callback;
+}
+
+/**
+ * Retorna quantos quadros deixaram de ser enviados por serem iguais ao anterior.
+ */
+uint32_t npGetSuppressedFrames() {
+    return np_suppressed_frames;
+}
+
+/**
+ * Retorna quantos pixels do fim da cadeia deixaram de ser enviados por não terem mudado.
+ */
+uint32_t npGetSkippedPixels() {
+    return np_skipped_pixels;
 }
 // Calcula o índice na matriz de LEDs
 // Linhas pares(0, 2, 4): esquerda para direita; ímpares(1, 3): direita para esquerda.
@@ -1,6 +1,7 @@
 #ifndef NEOPIXEL_H
 #define NEOPIXEL_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "hardware/pio.h"
 #include "hardware/clocks.h"
@@ -10,6 +11,10 @@
 #define LED_COUNT 25
 #define LED_PIN 7
 
+// Tempos após o fim da DMA: esvaziar a FIFO da PIO (8 palavras de 30 us) e reset/latch dos LEDs.
+#define NP_FIFO_DRAIN_US 240
+#define NP_RESET_US 300
+
 // Definição de pixel GRB
 typedef struct {
     uint8_t G, R, B; // Três valores de 8-bits compõem um pixel.
@@ -22,4 +27,12 @@ void npClear();
 void npWrite();
 int npGetIndex(int x, int y);
 
+// npWrite() não bloqueia; o fim do envio pode ser consultado ou avisado por callback (em IRQ)
+bool npWriteBusy();
+void npSetWriteCallback(void (*callback)(void));
+
+// Estatísticas dos envios evitados por npWrite()
+uint32_t npGetSuppressedFrames();
+uint32_t npGetSkippedPixels();
+
 #endif // NEOPIXEL_H
@@ -0,0 +1,149 @@
+#include "saida.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Segmentos deixados livres na fila do lwIP para as escritas pequenas (eventos, quadros WebSocket)
+#define SAIDA_FOLGA_SEGMENTOS 2
+// Espaço de "%X\r\n" + "\r\n" em volta de cada bloco chunked
+#define SAIDA_MOLDURA 8
+
+// Blocos gerados são copiados para o lwIP na hora, então um único buffer basta para todas as
+// conexões (os callbacks do lwIP nunca rodam ao mesmo tempo)
+static char bloco[SAIDA_MOLDURA + SAIDA_BLOCO + 2];
+
+void saida_init(saida_t *s, struct tcp_pcb *pcb) {
+    memset(s, 0, sizeof(*s));
+    s->pcb = pcb;
+}
+
+static saida_parte_t *nova_parte(saida_t *s) {
+    if (s->quantidade == SAIDA_PARTES) return NULL;
+    saida_parte_t *p = &s->partes[(s->inicio + s->quantidade++) % SAIDA_PARTES];
+    memset(p, 0, sizeof(*p));
+    return p;
+}
+
+uint32_t saida_adiciona(saida_t *s, const void *dados, uint32_t tam) {
+    saida_parte_t *p = nova_parte(s);
+    if (!p) return 0;
+
+    p->dados = dados;
+    p->tam = tam;
+    s->enfileirado += tam;
+    return s->enfileirado;
+}
+
+bool saida_adiciona_gerador(saida_t *s, saida_gerador_t gera, bool chunked) {
+    saida_parte_t *p = nova_parte(s);
+    if (!p) return false;
+
+    p->gera = gera;
+    p->chunked = chunked;
+    return true;
+}
+
+bool saida_gerando(const saida_t *s, saida_gerador_t gera) {
+    for (uint8_t i = 0; i < s->quantidade; i++) {
+        if (s->partes[(s->inicio + i) % SAIDA_PARTES].gera == gera) return true;
+    }
+    return false;
+}
+
+void saida_descarta(saida_t *s) {
+    s->quantidade = 0;
+    s->cursor = 0;
+    s->enfileirado = s->escrito;
+}
+
+bool saida_copia(saida_t *s, const void *dados, uint16_t tam) {
+    if (!saida_vazia(s) || tcp_sndbuf(s->pcb) < tam) return false;
+    if (tcp_write(s->pcb, dados, tam, TCP_WRITE_FLAG_COPY) != ERR_OK) return false;
+
+    s->escrito += tam;
+    s->enfileirado += tam;
+    return true;
+}
+
+// Há espaço no lwIP para mais uma escrita de pelo menos `minimo` bytes?
+static u16_t espaco(saida_t *s, u16_t minimo) {
+    if (tcp_sndqueuelen(s->pcb) + SAIDA_FOLGA_SEGMENTOS >= TCP_SND_QUEUELEN) return 0;
+    u16_t livre = tcp_sndbuf(s->pcb);
+    return livre >= minimo ? livre : 0;
+}
+
+// Gera e escreve um bloco de até `livre` bytes; *fim indica que o gerador terminou
+static err_t escreve_gerado(saida_t *s, saida_parte_t *p, u16_t livre, bool *fim) {
+    size_t max = livre - (p->chunked ? SAIDA_MOLDURA : 0);
+    if (max > SAIDA_BLOCO) max = SAIDA_BLOCO;
+
+    size_t n = p->gera(&s->cursor, bloco + SAIDA_MOLDURA, max);
+    size_t inicio = SAIDA_MOLDURA, tam = n;
+    *fim = (n == 0);
+
+    if (p->chunked) {
+        // Tamanho em hexadecimal antes do bloco e "\r\n" depois; o bloco vazio ("0\r\n\r\n") encerra o corpo
+        char cab[SAIDA_MOLDURA];
+        int c = snprintf(cab, sizeof(cab), "%X\r\n", (unsigned)n);
+        inicio -= c;
+        memcpy(bloco + inicio, cab, c);
+        memcpy(bloco + SAIDA_MOLDURA + n, "\r\n", 2);
+        tam += c + 2;
+    }
+    if (tam == 0) return ERR_OK;
+
+    err_t err = tcp_write(s->pcb, bloco + inicio, tam, TCP_WRITE_FLAG_COPY | (*fim ? 0 : TCP_WRITE_FLAG_MORE));
+    if (err == ERR_OK) {
+        s->escrito += tam;
+        s->enfileirado += tam;
+    }
+    return err;
+}
+
+bool saida_bombeia(saida_t *s) {
+    bool escreveu = false;
+
+    while (!saida_vazia(s)) {
+        saida_parte_t *p = &s->partes[s->inicio];
+        err_t err = ERR_OK;
+
+        if (p->gera) {
+            u16_t livre = espaco(s, 64);
+            if (!livre) break;
+
+            uint32_t cursor = s->cursor;
+            bool fim;
+            err = escreve_gerado(s, p, livre, &fim);
+            if (err == ERR_MEM) {
+                s->cursor = cursor;   // O mesmo bloco é gerado de novo na próxima vez
+                break;
+            }
+            if (err != ERR_OK) return false;
+            escreveu = true;
+            if (!fim) continue;
+            s->cursor = 0;
+        } else if (p->tam > 0) {
+            u16_t livre = espaco(s, 1);
+            if (!livre) break;
+
+            u16_t n = p->tam < livre ? p->tam : livre;
+            bool mais = n < p->tam || s->quantidade > 1;
+            err = tcp_write(s->pcb, p->dados, n, mais ? TCP_WRITE_FLAG_MORE : 0);
+            if (err == ERR_MEM) break;
+            if (err != ERR_OK) return false;
+
+            p->dados += n;
+            p->tam -= n;
+            s->escrito += n;
+            escreveu = true;
+            if (p->tam > 0) continue;
+        }
+
+        s->inicio = (s->inicio + 1) % SAIDA_PARTES;
+        s->quantidade--;
+    }
+
+    if (!saida_vazia(s)) s->esperas++;
+    if (escreveu) tcp_output(s->pcb);
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef SAIDA_H
+#define SAIDA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lwip/tcp.h"
+
+// Fila de saída de uma conexão TCP. A resposta é montada como uma sequência de partes, e as
+// partes são entregues ao lwIP no ritmo em que cabem no buffer de envio (tcp_sndbuf) e na fila
+// de segmentos (TCP_SND_QUEUELEN): saida_bombeia() é chamada depois de enfileirar e a cada
+// confirmação (tcp_sent). Assim uma resposta pode ser maior que TCP_SND_BUF.
+
+#define SAIDA_PARTES 8          // Partes pendentes por conexão
+#define SAIDA_BLOCO 1024        // Maior bloco pedido a um gerador de cada vez
+
+// Gerador de corpo: escreve até max bytes em buf e retorna quantos escreveu; 0 encerra o corpo.
+// cursor começa em 0 e é guardado entre chamadas. Para o mesmo cursor o gerador deve produzir
+// os mesmos bytes: um bloco que não coube no lwIP é gerado de novo mais tarde.
+typedef size_t (*saida_gerador_t)(uint32_t *cursor, char *buf, size_t max);
+
+typedef struct {
+    const char *dados;          // Referência (sem cópia): deve existir até ser confirmada
+    uint32_t tam;               // Bytes ainda não entregues ao lwIP
+    saida_gerador_t gera;       // Se não for NULL, a parte é gerada sob demanda
+    bool chunked;               // Gerador com Transfer-Encoding: chunked
+} saida_parte_t;
+
+typedef struct {
+    struct tcp_pcb *pcb;
+    saida_parte_t partes[SAIDA_PARTES];
+    uint8_t inicio;
+    uint8_t quantidade;
+    uint32_t cursor;            // Estado do gerador em andamento
+    uint32_t escrito;           // Total de bytes entregues ao lwIP
+    uint32_t enfileirado;       // escrito + bytes de referências ainda na fila
+    uint32_t esperas;           // Vezes em que a escrita parou por falta de espaço no lwIP
+} saida_t;
+
+void saida_init(saida_t *s, struct tcp_pcb *pcb);
+
+// Enfileira uma referência; retorna a posição no fluxo de saída logo após a parte (para saber
+// quando ela foi confirmada) ou 0 se a fila estiver cheia.
+uint32_t saida_adiciona(saida_t *s, const void *dados, uint32_t tam);
+
+// Enfileira um corpo gerado sob demanda; chunked o envia com Transfer-Encoding: chunked
+bool saida_adiciona_gerador(saida_t *s, saida_gerador_t gera, bool chunked);
+
+// Há um corpo deste gerador na fila, ainda não entregue por inteiro ao lwIP
+bool saida_gerando(const saida_t *s, saida_gerador_t gera);
+
+// Escreve dados pequenos copiando-os para o lwIP, apenas se não houver nada na fila à frente
+bool saida_copia(saida_t *s, const void *dados, uint16_t tam);
+
+// Entrega ao lwIP tudo o que couber agora; retorna false em erro fatal da conexão
+bool saida_bombeia(saida_t *s);
+
+// Abandona o que ainda não foi entregue ao lwIP
+void saida_descarta(saida_t *s);
+
+static inline bool saida_vazia(const saida_t *s) {
+    return s->quantidade == 0;
+}
+
+#endif // SAIDA_H
@@ -0,0 +1,55 @@
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hardware/sync.h"
+
+// Fila circular de um produtor e um consumidor (por exemplo, um em cada núcleo) sem locks: o
+// produtor só escreve em escrita e o consumidor só em leitura. Os itens ficam num vetor do
+// chamador com tam posições (potência de 2); as funções cuidam só dos índices e das barreiras
+// de memória que garantem que o item esteja escrito antes de ser visto pelo outro lado.
+
+typedef struct {
+    volatile uint32_t escrita;   // Itens publicados (só o produtor altera)
+    volatile uint32_t leitura;   // Itens consumidos (só o consumidor altera)
+    uint32_t mascara;            // tam - 1
+} spsc_t;
+
+static inline void spsc_init(spsc_t *f, uint32_t tam) {
+    f->escrita = 0;
+    f->leitura = 0;
+    f->mascara = tam - 1;
+}
+
+static inline uint32_t spsc_quantidade(const spsc_t *f) {
+    return f->escrita - f->leitura;
+}
+
+// Produtor: posição livre para montar o próximo item, ou -1 se a fila estiver cheia
+static inline int spsc_reserva(const spsc_t *f) {
+    if (spsc_quantidade(f) > f->mascara) return -1;
+    return f->escrita & f->mascara;
+}
+
+// Produtor: entrega ao consumidor o item montado na posição reservada
+static inline void spsc_publica(spsc_t *f) {
+    __dmb();   // O item deve estar na memória antes do índice
+    f->escrita = f->escrita + 1;
+}
+
+// Consumidor: posição do item mais antigo, ou -1 se a fila estiver vazia
+static inline int spsc_proximo(const spsc_t *f) {
+    if (spsc_quantidade(f) == 0) return -1;
+    __dmb();   // Lê o item só depois de ver o índice
+    return f->leitura & f->mascara;
+}
+
+// Consumidor: devolve a posição do item lido ao produtor
+static inline void spsc_consome(spsc_t *f) {
+    __dmb();   // Termina de ler o item antes de liberar a posição
+    f->leitura = f->leitura + 1;
+}
+
+#endif // SPSC_H
@@ -1,5 +1,10 @@
 #include "ssd1306.h"
 #include "font.h"
+#include "trace.h"
+
+#include "hardware/irq.h"
+
+#include <string.h>
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
   ssd->width = width;
@@ -10,7 +15,28 @@ void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_v
   ssd->bufsize = ssd->pages * ssd->width + 1;
   ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
   ssd->ram_buffer[0] = 0x40;
+  ssd->tx_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
+  ssd->tx_buffer[0] = 0x40;
+  ssd->dma_buffer = NULL;
+  ssd->dma_chan = -1;
   ssd->port_buffer[0] = 0x80;
+
+  // Nenhuma página alterada (min > max), qualquer que seja a memória de onde veio ssd
+  for (uint8_t p = 0; p < SSD1306_MAX_PAGES; ++p) {
+    ssd->dirty_min[p] = 0xFF;
+    ssd->dirty_max[p] = 0;
+  }
+
+  // A RAM do controlador começa com lixo: o primeiro envio deve cobrir a tela inteira
+  ssd1306_mark_dirty(ssd, 0, ssd->width - 1, 0, ssd->pages - 1);
+}
+
+// Marca as colunas x0..x1 das páginas page0..page1 como alteradas
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+  for (uint8_t p = page0; p <= page1; ++p) {
+    if (x0 < ssd->dirty_min[p]) ssd->dirty_min[p] = x0;
+    if (x1 > ssd->dirty_max[p]) ssd->dirty_max[p] = x1;
+  }
 }
 
 void ssd1306_config(ssd1306_t *ssd) {
@@ -52,23 +78,153 @@ void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   );
 }
 
+// Calcula a janela (colunas x páginas) que cobre as alterações desde o último envio e limpa as
+// marcações. Retorna false se nada mudou.
+static bool ssd1306_take_window(ssd1306_t *ssd, uint8_t *col0, uint8_t *col1, uint8_t *page0, uint8_t *page1) {
+  *col0 = 0xFF;
+  *col1 = 0;
+  *page0 = 0xFF;
+  *page1 = 0;
+
+  for (uint8_t p = 0; p < ssd->pages; ++p) {
+    if (ssd->dirty_min[p] > ssd->dirty_max[p]) continue;
+    if (p < *page0) *page0 = p;
+    *page1 = p;
+    if (ssd->dirty_min[p] < *col0) *col0 = ssd->dirty_min[p];
+    if (ssd->dirty_max[p] > *col1) *col1 = ssd->dirty_max[p];
+    ssd->dirty_min[p] = 0xFF;
+    ssd->dirty_max[p] = 0;
+  }
+  return *page0 != 0xFF;
+}
+
+// Envia apenas a janela (colunas x páginas) que cobre as alterações desde o último envio.
+// O display usa endereçamento vertical: a RAM é percorrida coluna a coluna, página a página.
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  uint8_t col0, col1, page0, page1;
+
+  // Não disputa o barramento com um envio por DMA em andamento
+  while (ssd1306_flush_busy(ssd))
+    tight_loop_contents();
+
+  if (!ssd1306_take_window(ssd, &col0, &col1, &page0, &page1)) return; // Nada mudou
+
+  // Endereçamento da janela em uma única transação de comandos (Co = 0, D/C = 0)
+  uint8_t commands[] = {0x00, SET_COL_ADDR, col0, col1, SET_PAGE_ADDR, page0, page1};
+  i2c_write_blocking(ssd->i2c_port, ssd->address, commands, sizeof(commands), false);
+
+  uint8_t npages = page1 - page0 + 1;
+  size_t len = (size_t)(col1 - col0 + 1) * npages;
+
+  if (npages == ssd->pages) {
+    // Colunas inteiras são contíguas em ram_buffer: envia direto, usando o byte anterior à
+    // janela como byte de controle de dados
+    uint8_t *start = &ssd->ram_buffer[col0 * ssd->pages];
+    uint8_t saved = *start;
+    *start = 0x40;
+    i2c_write_blocking(ssd->i2c_port, ssd->address, start, len + 1, false);
+    *start = saved;
+  } else {
+    uint8_t *out = &ssd->tx_buffer[1];
+    for (uint8_t x = col0; x <= col1; ++x) {
+      const uint8_t *column = &ssd->ram_buffer[x * ssd->pages + 1];
+      for (uint8_t p = page0; p <= page1; ++p)
+        *out++ = column[p];
+    }
+    i2c_write_blocking(ssd->i2c_port, ssd->address, ssd->tx_buffer, len + 1, false);
+  }
+}
+
+// Display com envio por DMA, para a interrupção de fim da transferência
+static ssd1306_t *ssd1306_dma_display;
+
+// Fim da DMA (para o trace): os últimos bytes ainda saem da FIFO do I2C depois daqui
+static void ssd1306_dma_handler(void) {
+  ssd1306_t *ssd = ssd1306_dma_display;
+  if (!ssd || !dma_channel_get_irq0_status(ssd->dma_chan)) return;
+  dma_channel_acknowledge_irq0(ssd->dma_chan);
+  trace_registra(TRACE_FLUSH_FIM, TRACE_SAIDA_DISPLAY);
+}
+
+// Reserva um canal de DMA para envios assíncronos (ritmado pelo DREQ de TX do I2C)
+static void ssd1306_dma_init(ssd1306_t *ssd) {
+  // Comandos (7) + byte de controle de dados + tela inteira
+  ssd->dma_buffer = calloc(7 + ssd->bufsize, sizeof(uint16_t));
+  if (!ssd->dma_buffer) return;
+
+  ssd->dma_chan = dma_claim_unused_channel(true);
+  dma_channel_config c = dma_channel_get_default_config(ssd->dma_chan);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, i2c_get_dreq(ssd->i2c_port, true));
+  dma_channel_configure(ssd->dma_chan, &c, &i2c_get_hw(ssd->i2c_port)->data_cmd, ssd->dma_buffer, 0, false);
+
+  // Interrupção compartilhada com a matriz de LEDs; cada tratador confere o próprio canal
+  ssd1306_dma_display = ssd;
+  dma_channel_set_irq0_enabled(ssd->dma_chan, true);
+  irq_add_shared_handler(DMA_IRQ_0, ssd1306_dma_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true);
+}
+
+// Indica se um envio por DMA ainda está em andamento (DMA ou FIFO/barramento do I2C ocupados)
+bool ssd1306_flush_busy(ssd1306_t *ssd) {
+  if (ssd->dma_chan < 0)
+    return false;
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  return dma_channel_is_busy(ssd->dma_chan) ||
+         !(hw->status & I2C_IC_STATUS_TFE_BITS) ||
+         (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS);
+}
+
+// Envia a janela alterada sem bloquear: comandos e dados são copiados para dma_buffer e a DMA
+// os entrega ao I2C como duas transações (cada uma terminada com STOP). Retorna false se um
+// envio anterior ainda estiver em andamento; nesse caso as alterações continuam marcadas.
+bool ssd1306_send_data_async(ssd1306_t *ssd) {
+  uint8_t col0, col1, page0, page1;
+
+  if (ssd->dma_chan < 0) {
+    ssd1306_send_data(ssd);
+    return true;
+  }
+  if (ssd1306_flush_busy(ssd))
+    return false;
+  if (!ssd1306_take_window(ssd, &col0, &col1, &page0, &page1))
+    return true;
+
+  uint16_t *out = ssd->dma_buffer;
+  const uint8_t commands[] = {0x00, SET_COL_ADDR, col0, col1, SET_PAGE_ADDR, page0, page1};
+  for (uint8_t i = 0; i < sizeof(commands); ++i)
+    *out++ = commands[i];
+  out[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+  *out++ = 0x40;
+  for (uint8_t x = col0; x <= col1; ++x) {
+    const uint8_t *column = &ssd->ram_buffer[x * ssd->pages + 1];
+    for (uint8_t p = page0; p <= page1; ++p)
+      *out++ = column[p];
+  }
+  out[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+  // Endereço do escravo e limpeza de um abort anterior (ex.: NACK), como o SDK faz em cada escrita
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  hw->enable = 0;
+  hw->tar = ssd->address;
+  hw->enable = 1;
+  (void)hw->clr_tx_abrt;
+  ssd->i2c_port->restart_on_next = false;
+
+  trace_registra(TRACE_FLUSH_INICIO, TRACE_SAIDA_DISPLAY);
+  dma_channel_transfer_from_buffer_now(ssd->dma_chan, ssd->dma_buffer, out - ssd->dma_buffer);
+  return true;
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
+  if (x >= ssd->width || y >= ssd->height)
+    return;
+  if (x < ssd->dirty_min[y >> 3]) ssd->dirty_min[y >> 3] = x;
+  if (x > ssd->dirty_max[y >> 3]) ssd->dirty_max[y >> 3] = x;
+
   uint16_t index = (y >> 3) + (x << 3) + 1;
   uint8_t pixel = (y & 0b111);
   if (value)
@@ -77,41 +233,59 @@ void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
     ssd->ram_buffer[index] &= ~(1 << pixel);
 }
 
-/*
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
+// Escreve os bits de mask de um byte da RAM (coluna x, página page) com os bits de bits
+static inline void ssd1306_write_masked(ssd1306_t *ssd, uint8_t x, uint8_t page, uint8_t mask, uint8_t bits) {
+  uint8_t *byte = &ssd->ram_buffer[x * ssd->pages + page + 1];
+  *byte = (*byte & ~mask) | (bits & mask);
+}
+
+// Preenche as linhas y0..y1 da coluna x (já dentro da tela), um byte por página
+static void ssd1306_span(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+  uint8_t bits = value ? 0xFF : 0x00;
+  uint8_t page0 = y0 >> 3, page1 = y1 >> 3;
+  uint8_t mask0 = 0xFF << (y0 & 7);
+  uint8_t mask1 = 0xFF >> (7 - (y1 & 7));
+
+  if (page0 == page1) {
+    ssd1306_write_masked(ssd, x, page0, mask0 & mask1, bits);
+    return;
+  }
+  ssd1306_write_masked(ssd, x, page0, mask0, bits);
+  uint8_t *column = &ssd->ram_buffer[x * ssd->pages + 1];
+  for (uint8_t p = page0 + 1; p < page1; ++p)
+    column[p] = bits;
+  ssd1306_write_masked(ssd, x, page1, mask1, bits);
+}
 
 void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+  memset(&ssd->ram_buffer[1], value ? 0xFF : 0x00, ssd->bufsize - 1);
+  ssd1306_mark_dirty(ssd, 0, ssd->width - 1, 0, ssd->pages - 1);
 }
 
 
 
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
-  }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
-  }
+  if (width == 0 || height == 0)
+    return;
+  uint8_t right = left + width - 1;
+  uint8_t bottom = top + height - 1;
 
   if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
+    // Retângulo cheio: um span vertical por coluna
+    if (left >= ssd->width || top >= ssd->height)
+      return;
+    if (right >= ssd->width) right = ssd->width - 1;
+    if (bottom >= ssd->height) bottom = ssd->height - 1;
+    for (uint8_t x = left; x <= right; ++x)
+      ssd1306_span(ssd, x, top, bottom, value);
+    ssd1306_mark_dirty(ssd, left, right, top >> 3, bottom >> 3);
+    return;
   }
+
+  ssd1306_hline(ssd, left, right, top, value);
+  ssd1306_hline(ssd, left, right, bottom, value);
+  ssd1306_vline(ssd, left, top, bottom, value);
+  ssd1306_vline(ssd, right, top, bottom, value);
 }
 
 void ssd1306_circle(ssd1306_t *ssd, int x0, int y0, int radius, bool value, bool fill) {
@@ -149,6 +323,16 @@ void ssd1306_circle(ssd1306_t *ssd, int x0, int y0, int radius, bool value, bool
 }
 
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+    // Linhas retas usam os spans de hline/vline
+    if (y0 == y1) {
+        ssd1306_hline(ssd, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, y0, value);
+        return;
+    }
+    if (x0 == x1) {
+        ssd1306_vline(ssd, x0, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, value);
+        return;
+    }
+
     int dx = abs(x1 - x0);
     int dy = abs(y1 - y0);
 
@@ -178,13 +362,27 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 
 
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  if (y >= ssd->height || x0 >= ssd->width || x0 > x1)
+    return;
+  if (x1 >= ssd->width) x1 = ssd->width - 1;
+
+  // Todos os pixels estão no mesmo bit da mesma página: avança uma coluna (pages bytes) por vez
+  uint8_t mask = 1 << (y & 7);
+  uint8_t *byte = &ssd->ram_buffer[x0 * ssd->pages + (y >> 3) + 1];
+  for (uint8_t x = x0; x <= x1; ++x, byte += ssd->pages) {
+    if (value) *byte |= mask;
+    else       *byte &= ~mask;
+  }
+  ssd1306_mark_dirty(ssd, x0, x1, y >> 3, y >> 3);
 }
 
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  if (x >= ssd->width || y0 >= ssd->height || y0 > y1)
+    return;
+  if (y1 >= ssd->height) y1 = ssd->height - 1;
+
+  ssd1306_span(ssd, x, y0, y1, value);
+  ssd1306_mark_dirty(ssd, x, x, y0 >> 3, y1 >> 3);
 }
 
 // Função para desenhar um caractere
@@ -203,15 +401,31 @@ void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
     index = 0; // Índice 0 corresponde ao caractere "nada" (espaço)
   }
 
-  // Desenha o caractere na tela
-  for (uint8_t i = 0; i < 8; ++i)
+  if (x >= ssd->width || y >= ssd->height)
+    return;
+
+  // Cada coluna do glifo é um byte com o bit 0 no topo, o mesmo formato das páginas do display.
+  // Alinhado a uma página, cada coluna é copiada direto; senão, é dividida entre duas páginas.
+  uint8_t page = y >> 3;
+  uint8_t shift = y & 7;
+  uint8_t last = (x + 7 < ssd->width) ? x + 7 : ssd->width - 1;
+  bool second_page = shift && page + 1 < ssd->pages;
+
+  for (uint8_t col = x; col <= last; ++col)
   {
-    uint8_t line = font[index + i]; // Acessa a linha correspondente do caractere na fonte
-    for (uint8_t j = 0; j < 8; ++j)
+    uint8_t line = font[index + (col - x)]; // Acessa a coluna correspondente do caractere na fonte
+    uint8_t *column = &ssd->ram_buffer[col * ssd->pages + page + 1];
+
+    if (!shift)
     {
-      ssd1306_pixel(ssd, x + i, y + j, line & (1 << j)); // Desenha cada pixel do caractere
+      column[0] = line;
+      continue;
     }
+    column[0] = (column[0] & ~(0xFF << shift)) | (line << shift);
+    if (second_page)
+      column[1] = (column[1] & ~(0xFF >> (8 - shift))) | (line >> (8 - shift));
   }
+  ssd1306_mark_dirty(ssd, x, last, page, second_page ? page + 1 : page);
 }
 
 // Função para desenhar uma string
@@ -234,8 +448,8 @@ void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y)
 }
 
 void display_init(ssd1306_t *ssd) {
-  // Configuração I2C a 400kHz
-  i2c_init(I2C_PORT, 400 * 1000);
+  // Configuração I2C a 400kHz (ou 1MHz com SSD1306_I2C_FAST_MODE_PLUS)
+  i2c_init(I2C_PORT, SSD1306_I2C_BAUD);
   
   // Configura pinos I2C
   gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
@@ -245,6 +459,7 @@ void display_init(ssd1306_t *ssd) {
 
   // Inicialização do controlador SSD1306
   ssd1306_init(ssd, WIDTH, HEIGHT, false, endereco, I2C_PORT);
+  ssd1306_dma_init(ssd);
   ssd1306_config(ssd);
   ssd1306_send_data(ssd);
 
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "hardware/dma.h"
 
 #define WIDTH 128
 #define HEIGHT 64
@@ -10,6 +11,15 @@
 #define I2C_SCL 15
 #define endereco 0x3C
 
+#define SSD1306_MAX_PAGES 8
+
+// Fast-mode Plus (1 MHz) no barramento do display. O SSD1306 é especificado para 400 kHz, mas a
+// maioria dos módulos funciona a 1 MHz com pull-ups externos fortes (~2,2 kOhm).
+#ifndef SSD1306_I2C_FAST_MODE_PLUS
+#define SSD1306_I2C_FAST_MODE_PLUS 0
+#endif
+#define SSD1306_I2C_BAUD (SSD1306_I2C_FAST_MODE_PLUS ? 1000 * 1000 : 400 * 1000)
+
 typedef enum {
   SET_CONTRAST = 0x81,
   SET_ENTIRE_ON = 0xA4,
@@ -37,12 +47,23 @@ typedef struct {
   uint8_t *ram_buffer;
   size_t bufsize;
   uint8_t port_buffer[2];
+  // Colunas alteradas em cada página desde o último envio (min > max = página limpa)
+  uint8_t dirty_min[SSD1306_MAX_PAGES];
+  uint8_t dirty_max[SSD1306_MAX_PAGES];
+  uint8_t *tx_buffer;           // Área para montar janelas que não são contíguas em ram_buffer
+  // Envio por DMA: comandos e dados são copiados para dma_buffer (já no formato do registrador
+  // DATA_CMD), então o desenho em ram_buffer pode continuar enquanto a DMA envia
+  uint16_t *dma_buffer;
+  int dma_chan;                 // -1 = sem DMA
 } ssd1306_t;
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
 void ssd1306_config(ssd1306_t *ssd);
 void ssd1306_command(ssd1306_t *ssd, uint8_t command);
 void ssd1306_send_data(ssd1306_t *ssd);
+bool ssd1306_send_data_async(ssd1306_t *ssd);
+bool ssd1306_flush_busy(ssd1306_t *ssd);
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1);
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
@@ -0,0 +1,192 @@
+#include "temporizador.h"
+
+// Cada nível tem 64 posições: o nível 0 separa os próximos 64 ms, um por posição; cada
+// posição do nível n cobre 64^n ms. Um temporizador desce de nível (cascata) quando a roda
+// chega à sua posição, até disparar no nível 0.
+#define BITS 6
+#define TAM (1u << BITS)
+#define MASCARA (TAM - 1)
+#define NIVEIS 4
+#define ALCANCE (1u << (BITS * NIVEIS))   // 2^24 ms
+#define FORA 0xFFFF                       // Retirado da roda para disparar
+
+static temporizador_t *roda[NIVEIS * TAM];
+static uint64_t ocupadas[NIVEIS];     // Bit i: a posição i do nível tem temporizadores
+static uint32_t agora;                // Próximo ms a processar
+static uint32_t prazo_informado;      // Próximo tick (ms da roda) da última temporizador_proximo()
+static bool tem_prazo_informado;
+static void (*aviso_antecipar)(void);
+static void (*aviso_disparo)(const temporizador_t *t, bool fim);
+static uint32_t (*relogio_ms)(void);
+
+static inline uint64_t gira(uint64_t bits, unsigned n) {
+    return n ? (bits >> n) | (bits << (64 - n)) : bits;
+}
+
+// Encadeia o temporizador na posição correspondente ao seu prazo
+static void insere(temporizador_t *t) {
+    uint32_t expira = t->expira;
+    int32_t delta = (int32_t)(expira - agora);
+    unsigned nivel = 0, indice;
+
+    if (delta < 0) {
+        indice = agora & MASCARA;   // Atrasado: dispara no próximo ms processado
+    } else {
+        if ((uint32_t)delta >= ALCANCE) {
+            // Fora do alcance: espera no fim da roda e é reinserido na cascata
+            expira = agora + ALCANCE - 1;
+            delta = ALCANCE - 1;
+        }
+        while ((uint32_t)delta >= (1u << (BITS * (nivel + 1)))) nivel++;
+        indice = (expira >> (BITS * nivel)) & MASCARA;
+    }
+
+    uint16_t posicao = nivel * TAM + indice;
+    t->posicao = posicao;
+    t->prox = roda[posicao];
+    if (t->prox) t->prox->anterior = &t->prox;
+    roda[posicao] = t;
+    t->anterior = &roda[posicao];
+    ocupadas[nivel] |= 1ull << indice;
+}
+
+// Desencadeia o temporizador da lista em que está
+static void retira(temporizador_t *t) {
+    *t->anterior = t->prox;
+    if (t->prox) t->prox->anterior = t->anterior;
+    if (t->posicao != FORA && !roda[t->posicao]) ocupadas[t->posicao / TAM] &= ~(1ull << (t->posicao % TAM));
+    t->prox = NULL;
+    t->anterior = NULL;
+}
+
+// Redistribui os temporizadores de uma posição pelos níveis de baixo; retorna o índice
+static unsigned cascata(unsigned nivel, unsigned indice) {
+    temporizador_t *t = roda[nivel * TAM + indice];
+
+    roda[nivel * TAM + indice] = NULL;
+    ocupadas[nivel] &= ~(1ull << indice);
+    while (t) {
+        temporizador_t *prox = t->prox;
+        insere(t);
+        t = prox;
+    }
+    return indice;
+}
+
+// Primeiro ms, a partir de agora, em que há temporizadores a disparar ou uma posição ocupada a
+// descer de nível
+static bool proximo_tick(uint32_t *tick) {
+    bool achou = false;
+
+    for (unsigned nivel = 0; nivel < NIVEIS; nivel++) {
+        if (!ocupadas[nivel]) continue;
+
+        // Primeira fronteira do nível a partir de agora (arredondada para cima)
+        unsigned desloc = BITS * nivel;
+        uint32_t base = (agora >> desloc) + ((agora & ((1u << desloc) - 1)) != 0);
+        unsigned k = __builtin_ctzll(gira(ocupadas[nivel], base & MASCARA));
+        uint32_t t = (base + k) << desloc;
+
+        if (!achou || (int32_t)(t - agora) < (int32_t)(*tick - agora)) *tick = t;
+        achou = true;
+    }
+    return achou;
+}
+
+// Processa o ms atual: desce os níveis que chegaram a uma fronteira e dispara a posição
+static void processa_tick(void) {
+    unsigned indice = agora & MASCARA;
+
+    if (indice == 0) {
+        for (unsigned nivel = 1; nivel < NIVEIS; nivel++) {
+            if (cascata(nivel, (agora >> (BITS * nivel)) & MASCARA) != 0) break;
+        }
+    }
+
+    // A lista é retirada da roda antes dos disparos: um callback pode agendar ou cancelar
+    // qualquer temporizador, inclusive os que ainda estão nela
+    temporizador_t *lista = roda[indice];
+    roda[indice] = NULL;
+    ocupadas[0] &= ~(1ull << indice);
+    if (lista) lista->anterior = &lista;
+    for (temporizador_t *t = lista; t; t = t->prox) t->posicao = FORA;
+    agora++;
+
+    while (lista) {
+        temporizador_t *t = lista;
+        retira(t);
+        if (t->periodo) {
+            t->expira += t->periodo;   // Sem deriva: o próximo disparo conta do prazo, não do atraso
+            insere(t);
+        }
+        if (aviso_disparo) aviso_disparo(t, false);
+        t->fn(t);
+        if (aviso_disparo) aviso_disparo(t, true);   // t pode ter sido reagendado ou cancelado
+    }
+}
+
+void temporizador_roda_init(uint32_t (*relogio)(void)) {
+    for (unsigned i = 0; i < NIVEIS * TAM; i++) roda[i] = NULL;
+    for (unsigned i = 0; i < NIVEIS; i++) ocupadas[i] = 0;
+    relogio_ms = relogio;
+    agora = relogio();
+    tem_prazo_informado = false;
+}
+
+void temporizador_ao_antecipar(void (*aviso)(void)) {
+    aviso_antecipar = aviso;
+}
+
+void temporizador_ao_disparar(void (*aviso)(const temporizador_t *t, bool fim)) {
+    aviso_disparo = aviso;
+}
+
+void temporizador_init(temporizador_t *t, temporizador_fn_t fn, void *arg) {
+    t->prox = NULL;
+    t->anterior = NULL;
+    t->periodo = 0;
+    t->fn = fn;
+    t->arg = arg;
+}
+
+void temporizador_agenda(temporizador_t *t, uint32_t atraso_ms, uint32_t periodo_ms) {
+    if (t->anterior) retira(t);
+
+    // A roda pode estar parada desde o último processamento: o prazo conta do relógio
+    t->expira = relogio_ms() + atraso_ms;
+    t->periodo = periodo_ms;
+    insere(t);
+
+    if (aviso_antecipar && (!tem_prazo_informado || (int32_t)(t->expira - prazo_informado) < 0)) {
+        aviso_antecipar();
+    }
+}
+
+void temporizador_cancela(temporizador_t *t) {
+    if (t->anterior) retira(t);
+}
+
+void temporizador_processa(void) {
+    uint32_t agora_ms = relogio_ms();
+    uint32_t tick;
+
+    // Pula direto para o próximo ms com trabalho: entre eles não há nada a disparar nem a descer
+    while ((int32_t)(agora_ms - agora) >= 0) {
+        if (!proximo_tick(&tick) || (int32_t)(tick - agora_ms) > 0) {
+            agora = agora_ms + 1;
+            break;
+        }
+        agora = tick;
+        processa_tick();
+    }
+}
+
+bool temporizador_proximo(uint32_t *espera_ms) {
+    int32_t falta;
+
+    tem_prazo_informado = proximo_tick(&prazo_informado);
+    if (!tem_prazo_informado) return false;
+    falta = (int32_t)(prazo_informado - relogio_ms());
+    *espera_ms = falta > 0 ? (uint32_t)falta : 0;
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef TEMPORIZADOR_H
+#define TEMPORIZADOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Roda de temporizadores hierárquica, com resolução de 1 ms. Cada temporizador é uma estrutura
+// do chamador (sem alocação e sem limite de quantidade) que fica encadeada numa das 4 x 64
+// posições da roda: agendar e cancelar são O(1), e o processamento só visita as posições
+// ocupadas. Prazos até ~4,6 h (2^24 ms); prazos maiores são reagendados ao chegar no fim da roda.
+//
+// As funções não são reentrantes: devem ser chamadas sempre do mesmo contexto (no firmware,
+// o loop principal com cyw43_arch_lwip_begin() ou os callbacks do lwIP).
+
+typedef struct temporizador temporizador_t;
+
+typedef void (*temporizador_fn_t)(temporizador_t *t);
+
+struct temporizador {
+    temporizador_t *prox;
+    temporizador_t **anterior;  // Ponteiro que aponta para este na lista; NULL se inativo
+    uint32_t expira;            // Momento do disparo (ms do relógio da roda)
+    uint32_t periodo;           // Intervalo de repetição em ms; 0 dispara uma vez
+    uint16_t posicao;           // Posição na roda (nível * 64 + índice)
+    temporizador_fn_t fn;
+    void *arg;
+};
+
+// Prepara a roda; relogio retorna o momento atual em ms (no firmware, ms desde o boot)
+void temporizador_roda_init(uint32_t (*relogio)(void));
+
+// Função chamada quando um agendamento antecipa o próximo prazo informado por
+// temporizador_proximo() (por exemplo, para acordar quem está dormindo até ele)
+void temporizador_ao_antecipar(void (*aviso)(void));
+
+// Função chamada antes (fim = false) e depois (fim = true) de cada callback, por exemplo para
+// medir os disparos
+void temporizador_ao_disparar(void (*aviso)(const temporizador_t *t, bool fim));
+
+void temporizador_init(temporizador_t *t, temporizador_fn_t fn, void *arg);
+
+// Agenda o disparo para daqui a atraso_ms e, com periodo_ms > 0, a cada periodo_ms depois
+// disso. Um temporizador já ativo é reagendado.
+void temporizador_agenda(temporizador_t *t, uint32_t atraso_ms, uint32_t periodo_ms);
+
+void temporizador_cancela(temporizador_t *t);
+
+static inline bool temporizador_ativo(const temporizador_t *t) {
+    return t->anterior != NULL;
+}
+
+// Dispara os temporizadores vencidos, ms a ms, até o momento atual
+void temporizador_processa(void);
+
+// Informa em *espera_ms quantos ms faltam, a partir do relógio da roda agora, até
+// temporizador_processa() ter trabalho a fazer (0 se já tem); retorna false se não há
+// temporizadores ativos. O relógio da roda dá a volta (2^32 ms): quem dorme até o prazo deve
+// somar a espera ao seu próprio relógio, e não converter o momento em ms da roda.
+bool temporizador_proximo(uint32_t *espera_ms);
+
+#endif // TEMPORIZADOR_H
@@ -0,0 +1,114 @@
+#include "trace.h"
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#define NUCLEOS 2
+#define MASCARA (TRACE_EVENTOS - 1)
+
+typedef struct {
+    volatile uint32_t sequencia;   // Posição absoluta + 1 depois de escrito (0 = nunca escrito)
+    uint32_t us;
+    uint16_t arg;
+    uint8_t tipo;
+} evento_t;
+
+typedef struct {
+    evento_t eventos[TRACE_EVENTOS];
+    volatile uint32_t reservados;   // Posições já entregues a escritores (só o núcleo dono altera)
+    volatile uint32_t lidos;        // Eventos tirados por trace_drena() (só o leitor altera)
+    volatile uint32_t descartados;
+    spin_lock_t *trava;
+} anel_t;
+
+static anel_t aneis[NUCLEOS];
+
+// A trava de cada anel só é disputada pelos contextos do próprio núcleo, que já se excluem com
+// as interrupções desabilitadas: no RP2040 ela nunca espera. No host, onde as interrupções são
+// threads, é ela que serializa as reservas.
+void trace_init(void) {
+    for (int n = 0; n < NUCLEOS; n++) {
+        aneis[n].trava = spin_lock_instance(spin_lock_claim_unused(true));
+    }
+}
+
+void trace_registra(trace_tipo_t tipo, uint16_t arg) {
+    anel_t *a = &aneis[get_core_num()];
+    if (!a->trava) return;   // Antes de trace_init()
+
+    uint32_t us = time_us_32();
+    uint32_t irq = spin_lock_blocking(a->trava);
+    uint32_t pos = a->reservados;
+    bool cheio = pos - a->lidos >= TRACE_EVENTOS;
+    if (cheio) a->descartados++;
+    else a->reservados = pos + 1;
+    spin_unlock(a->trava, irq);
+    if (cheio) return;
+
+    evento_t *e = &a->eventos[pos & MASCARA];
+    e->us = us;
+    e->arg = arg;
+    e->tipo = tipo;
+    __dmb();   // O evento deve estar na memória antes da sequência
+    e->sequencia = pos + 1;
+}
+
+static void escreve_u16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void escreve_u32(uint8_t *p, uint32_t v) {
+    escreve_u16(p, v);
+    escreve_u16(p + 2, v >> 16);
+}
+
+// Tira do anel os eventos já escritos, até o primeiro ainda em escrita (um escritor
+// interrompido entre a reserva e a sequência segura os seguintes até terminar)
+static size_t drena_anel(anel_t *a, unsigned nucleo, uint8_t *buf) {
+    uint32_t pos = a->lidos;
+    uint8_t *p = buf + TRACE_CABECALHO;
+    uint16_t n = 0;
+
+    while (pos != a->reservados) {
+        const evento_t *e = &a->eventos[pos & MASCARA];
+        if (e->sequencia != pos + 1) break;
+        __dmb();   // Lê o evento só depois de ver a sequência
+
+        escreve_u32(p, e->us);
+        escreve_u16(p + 4, e->arg);
+        p[6] = e->tipo;
+        p[7] = 0;
+        p += TRACE_EVENTO;
+        pos++;
+        n++;
+    }
+    if (n == 0) return 0;
+
+    __dmb();   // Termina de ler os eventos antes de liberar as posições
+    a->lidos = pos;
+
+    memcpy(buf, "RVTR", 4);
+    buf[4] = TRACE_VERSAO;
+    buf[5] = nucleo;
+    escreve_u16(buf + 6, n);
+    escreve_u32(buf + 8, a->descartados);
+    return p - buf;
+}
+
+size_t trace_drena(uint8_t *buf, unsigned *nucleo) {
+    for (int i = 0; i < NUCLEOS; i++) {
+        unsigned n = *nucleo;
+        *nucleo = (n + 1) % NUCLEOS;   // Alterna os núcleos entre as chamadas
+        size_t tam = drena_anel(&aneis[n], n, buf);
+        if (tam) return tam;
+    }
+    return 0;
+}
+
+uint32_t trace_descartados(void) {
+    return aneis[0].descartados + aneis[1].descartados;
+}
@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Trace de eventos com marca de tempo (µs do timer), gravado de qualquer contexto: loop
+// principal, callbacks do lwIP, núcleo 1 e interrupções (botões, DMA, alarmes). Cada núcleo
+// tem o seu anel: o escritor reserva a posição com as interrupções do núcleo desabilitadas por
+// poucas instruções (o M0+ não tem instruções atômicas) e nunca espera pelo outro núcleo. A
+// posição só é vista pelo leitor depois de escrita, pelo número de sequência gravado por último.
+// Com o anel cheio o evento é descartado e contado, sem bloquear quem grava.
+//
+// trace_drena() é o único leitor (no firmware, o loop principal) e tira os eventos em blocos
+// binários, no formato lido por tools/trace2chrome.py:
+//   cabeçalho (12 bytes): "RVTR", versão (1), núcleo, quantidade (u16), descartados (u32)
+//   eventos (8 bytes cada): tempo em µs (u32), argumento (u16), tipo (u8), 0
+// Os números são little-endian; o tempo dá a volta a cada ~71 min, e descartados é o total
+// desde o boot naquele núcleo.
+
+#define TRACE_EVENTOS 256                 // Posições do anel de cada núcleo (potência de 2)
+#define TRACE_VERSAO 1
+#define TRACE_CABECALHO 12
+#define TRACE_EVENTO 8
+#define TRACE_BLOCO_MAX (TRACE_CABECALHO + TRACE_EVENTOS * TRACE_EVENTO)
+
+typedef enum {
+    TRACE_REQUISICAO = 1,   // Requisição HTTP recebida (arg = rota << 8 | conexão)
+    TRACE_RESPOSTA,         // Resposta entregue ao lwIP (arg = rota << 8 | conexão)
+    TRACE_COMANDO,          // Comando aplicado ao mundo (arg = letra do comando)
+    TRACE_RENDER_INICIO,    // Núcleo 1 começa a desenhar um quadro
+    TRACE_RENDER_FIM,
+    TRACE_FLUSH_INICIO,     // Envio começou (arg = TRACE_SAIDA_*)
+    TRACE_FLUSH_FIM,        // Envio terminou (arg = TRACE_SAIDA_*)
+    TRACE_ALARME,           // Temporizador disparou (arg = identificação dada pelo firmware)
+    TRACE_ALARME_FIM,       // Callback do temporizador retornou
+    TRACE_BOTAO,            // Interrupção de botão (arg = GPIO)
+    TRACE_ESPERA_INICIO,    // Loop principal vai dormir
+    TRACE_ESPERA_FIM,       // Loop principal acordou
+} trace_tipo_t;
+
+#define TRACE_SAIDA_MATRIZ 0    // Matriz de LEDs: DMA para a PIO até o fim do latch
+#define TRACE_SAIDA_DISPLAY 1   // Display: DMA para o I2C
+
+// Reserva os spin locks dos anéis; deve ser chamada antes de qualquer evento
+void trace_init(void);
+
+void trace_registra(trace_tipo_t tipo, uint16_t arg);
+
+// Escreve em buf (com pelo menos TRACE_BLOCO_MAX bytes) um bloco com os eventos prontos de um
+// núcleo, tentando primeiro o núcleo *nucleo; *nucleo avança a cada chamada, para alternar os
+// anéis. Retorna o tamanho do bloco, ou 0 se não há eventos em nenhum anel.
+size_t trace_drena(uint8_t *buf, unsigned *nucleo);
+
+// Eventos descartados por anel cheio, somados os dois núcleos
+uint32_t trace_descartados(void);
+
+#endif // TRACE_H
@@ -0,0 +1,125 @@
+#include "websocket.h"
+
+#include <string.h>
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+// SHA-1 mínimo, usado apenas no handshake (uma vez por conexão)
+typedef struct {
+    uint32_t h[5];
+    uint8_t bloco[64];
+    uint32_t usado;
+    uint64_t total;
+} sha1_t;
+
+static inline uint32_t rol(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+static void sha1_processa(sha1_t *s) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)s->bloco[4 * i] << 24 | (uint32_t)s->bloco[4 * i + 1] << 16 |
+               (uint32_t)s->bloco[4 * i + 2] << 8 | s->bloco[4 * i + 3];
+    }
+    for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = s->h[0], b = s->h[1], c = s->h[2], d = s->h[3], e = s->h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+        uint32_t t = rol(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    }
+    s->h[0] += a;
+    s->h[1] += b;
+    s->h[2] += c;
+    s->h[3] += d;
+    s->h[4] += e;
+}
+
+static void sha1_adiciona(sha1_t *s, const void *dados, size_t tam) {
+    const uint8_t *p = dados;
+    s->total += tam;
+    while (tam--) {
+        s->bloco[s->usado++] = *p++;
+        if (s->usado == 64) {
+            sha1_processa(s);
+            s->usado = 0;
+        }
+    }
+}
+
+static void sha1_finaliza(sha1_t *s, uint8_t resumo[20]) {
+    uint64_t bits = s->total * 8;
+    uint8_t um = 0x80, zero = 0;
+
+    sha1_adiciona(s, &um, 1);
+    while (s->usado != 56) sha1_adiciona(s, &zero, 1);
+    for (int i = 7; i >= 0; i--) {
+        uint8_t b = bits >> (8 * i);
+        sha1_adiciona(s, &b, 1);
+    }
+    for (int i = 0; i < 20; i++) resumo[i] = s->h[i / 4] >> (24 - 8 * (i % 4));
+}
+
+void ws_chave_aceite(const char *chave, size_t tam, char saida[29]) {
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    sha1_t s = { .h = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 } };
+    uint8_t r[21];
+
+    sha1_adiciona(&s, chave, tam);
+    sha1_adiciona(&s, WS_GUID, sizeof(WS_GUID) - 1);
+    sha1_finaliza(&s, r);
+    r[20] = 0;
+
+    // 20 bytes -> 28 caracteres (o último grupo tem 2 bytes e termina com '=')
+    for (int i = 0, o = 0; i < 21; i += 3, o += 4) {
+        uint32_t v = (uint32_t)r[i] << 16 | (uint32_t)r[i + 1] << 8 | (i + 2 < 21 ? r[i + 2] : 0);
+        saida[o] = b64[(v >> 18) & 63];
+        saida[o + 1] = b64[(v >> 12) & 63];
+        saida[o + 2] = b64[(v >> 6) & 63];
+        saida[o + 3] = b64[v & 63];
+    }
+    saida[27] = '=';
+    saida[28] = '\0';
+}
+
+int ws_decodifica(uint8_t *buf, size_t tam, ws_opcode_t *op, uint8_t **payload, size_t *payload_tam) {
+    if (tam < 2) return 0;
+
+    bool final = buf[0] & 0x80;
+    bool mascarado = buf[1] & 0x80;
+    size_t n = buf[1] & 0x7F;
+
+    // Comandos são pequenos: quadros fragmentados, sem máscara ou com tamanho estendido são recusados
+    if (!final || !mascarado || n > WS_PAYLOAD_MAX) return -1;
+    if (tam < 6 + n) return 0;
+
+    const uint8_t *mascara = &buf[2];
+    for (size_t i = 0; i < n; i++) buf[6 + i] ^= mascara[i & 3];
+
+    *op = (ws_opcode_t)(buf[0] & 0x0F);
+    *payload = &buf[6];
+    *payload_tam = n;
+    return (int)(6 + n);
+}
+
+size_t ws_cabecalho(uint8_t *buf, ws_opcode_t op, size_t payload_tam) {
+    buf[0] = 0x80 | op;
+    if (payload_tam < 126) {
+        buf[1] = payload_tam;
+        return 2;
+    }
+    buf[1] = 126;
+    buf[2] = payload_tam >> 8;
+    buf[3] = payload_tam & 0xFF;
+    return 4;
+}
@@ -0,0 +1,34 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Tipos de quadro (RFC 6455)
+typedef enum {
+    WS_CONTINUACAO = 0x0,
+    WS_TEXTO       = 0x1,
+    WS_BINARIO     = 0x2,
+    WS_FECHAR      = 0x8,
+    WS_PING        = 0x9,
+    WS_PONG        = 0xA
+} ws_opcode_t;
+
+// Maior payload aceito de um cliente (quadros de controle também são limitados a 125 bytes)
+#define WS_PAYLOAD_MAX 125
+// Maior quadro de cliente: 2 bytes de cabeçalho + 4 de máscara + payload
+#define WS_QUADRO_MAX (2 + 4 + WS_PAYLOAD_MAX)
+
+// Calcula o Sec-WebSocket-Accept (base64 de SHA-1(chave + GUID)) em saida (29 bytes com o '\0')
+void ws_chave_aceite(const char *chave, size_t tam, char saida[29]);
+
+// Decodifica um quadro de cliente do início de buf, desfazendo a máscara no próprio buffer.
+// Retorna os bytes consumidos, 0 se o quadro ainda está incompleto ou -1 se for inválido
+// (sem máscara, fragmentado ou maior que WS_PAYLOAD_MAX).
+int ws_decodifica(uint8_t *buf, size_t tam, ws_opcode_t *op, uint8_t **payload, size_t *payload_tam);
+
+// Escreve o cabeçalho de um quadro do servidor (final, sem máscara) e retorna o seu tamanho (2 ou 4)
+size_t ws_cabecalho(uint8_t *buf, ws_opcode_t op, size_t payload_tam);
+
+#endif // WEBSOCKET_H
@@ -19,8 +19,13 @@
 #define MEM_LIBC_MALLOC             0
 #endif
 #define MEM_ALIGNMENT               4
-#define MEM_SIZE                    4000
+// Escritas com cópia (blocos gerados de /mapa, eventos e quadros WebSocket) saem deste heap;
+// com 4000 bytes um corpo gerado ficava limitado a pouco mais de dois segmentos em voo
+#define MEM_SIZE                    12000
 #define MEMP_NUM_TCP_SEG            32
+// main.c atende até HTTP_MAX_CONEXOES (8) conexões; os PCBs restantes ficam para as conexões
+// em TIME_WAIT e para recusar novas conexões com um 503 (o padrão do lwIP é só 5)
+#define MEMP_NUM_TCP_PCB            12
 #define MEMP_NUM_ARP_QUEUE          10
 #define PBUF_POOL_SIZE              24
 #define LWIP_ARP                    1
@@ -35,10 +40,21 @@
 #define LWIP_NETIF_LINK_CALLBACK    1
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETCONN                0
-#define MEM_STATS                   0
+// Contadores do lwIP lidos pelo /metrics de main.c, também nas versões sem depuração: uso e pico
+// de cada pool (PCBs, segmentos, pbufs), do heap e pacotes da interface. Os contadores de cada
+// protocolo ficam desligados; com LWIP_STATS_LARGE eles têm 32 bits e não voltam a zero em minutos.
+#define LWIP_STATS                  1
+#define LWIP_STATS_LARGE            1
+#define MEM_STATS                   1
 #define SYS_STATS                   0
-#define MEMP_STATS                  0
-#define LINK_STATS                  0
+#define MEMP_STATS                  1
+#define LINK_STATS                  1
+#define ETHARP_STATS                0
+#define IP_STATS                    0
+#define IPFRAG_STATS                0
+#define ICMP_STATS                  0
+#define UDP_STATS                   0
+#define TCP_STATS                   0
 // #define ETH_PAD_SIZE                2
 #define LWIP_CHKSUM_ALGORITHM       3
 #define LWIP_DHCP                   1
@@ -47,13 +63,15 @@
 #define LWIP_UDP                    1
 #define LWIP_DNS                    1
 #define LWIP_TCP_KEEPALIVE          1
-#define LWIP_NETIF_TX_SINGLE_PBUF   1
+// Com 1, o tcp_write() força TCP_WRITE_FLAG_COPY; desligado, as partes fixas da página são
+// enviadas direto da flash. O driver do cyw43 já copia cadeias de pbufs para o seu buffer de SPI.
+#define LWIP_NETIF_TX_SINGLE_PBUF   0
+#define MEMP_NUM_PBUF               24
 #define DHCP_DOES_ARP_CHECK         0
 #define LWIP_DHCP_DOES_ACD_CHECK    0
 
 #ifndef NDEBUG
 #define LWIP_DEBUG                  1
-#define LWIP_STATS                  1
 #define LWIP_STATS_DISPLAY          1
 #endif
 
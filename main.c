@@ -6,16 +6,29 @@
 #include "pico/bootrom.h"
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"   
+#include "pico/multicore.h"
+#include "pico/stdio_usb.h"
+#include "pico/stdio/driver.h"
 #include "hardware/timer.h"
 #include "hardware/adc.h"
 
 #include "lib/ssd1306.h"
 #include "lib/neopixel.h"
 #include "lib/buzzer.h"
+#include "lib/mapa.h"
+#include "lib/fov.h"
+#include "lib/websocket.h"
+#include "lib/http.h"
+#include "lib/saida.h"
+#include "lib/temporizador.h"
+#include "lib/spsc.h"
+#include "lib/metricas.h"
+#include "lib/trace.h"
   
 #include "lwip/pbuf.h"           // Lightweight IP stack - manipulação de buffers de pacotes de rede
 #include "lwip/tcp.h"            // Lightweight IP stack - fornece funções e estruturas para trabalhar com o protocolo TCP
 #include "lwip/netif.h"          // Lightweight IP stack - fornece funções e estruturas para trabalhar com interfaces de rede (netif)
+#include "lwip/stats.h"          // Lightweight IP stack - contadores de uso dos pools, do heap e da interface (/metrics)
 
 // Credenciais WIFI - Tome cuidado se publicar no github!
 #define WIFI_SSID "SSID"
@@ -53,44 +66,102 @@ static ssd1306_t ssd;
 //      Variáveis do Programa        
 //===================================
 
-#define VAZIO      0
-#define MAQUINA_1  1
-#define MAQUINA_2  2
-#define INTRUSO    3
-#define OBSTACULO  9
-
-#define COMBUSTIVEL_1 4 // Combustivel relativo a máquina 1
-#define COMBUSTIVEL_2 5 // Combustivel relativo a máquina 2
 #define COMBUSTIVEL_MAX 2 // Quantidade máxima que o máquina pode armazenar
 
-#define MAPA_TAM 5
+// Lado da janela do mapa exibida na matriz de LEDs (acompanha o robô)
+#define VIEWPORT_TAM 5
 
-int mapa[5][5] = {
-    {0, 0, 0, 1, 4},
-    {0, 9, 0, 0, 0},
-    {3, 9, 0, 0, 0},
-    {0, 9, 0, 0, 0},
-    {0, 0, 0, 2, 5}
-};
+// Layout inicial da fábrica (uma célula por byte); o mapa pode ter até MAPA_MAX x MAPA_MAX
+#define MAPA_LARGURA 5
+#define MAPA_ALTURA  5
 
-// Coordenadas do Robo
-int robo_x = 2;
-int robo_y = 2;
+static const uint8_t mapa_inicial[MAPA_ALTURA * MAPA_LARGURA] = {
+    0, 0, 0, 1, 4,
+    0, 9, 0, 0, 0,
+    3, 9, 0, 0, 0,
+    0, 9, 0, 0, 0,
+    0, 0, 0, 2, 5
+};
 
-uint combustivel_robo = 0; // 0 - Nenhum; 4 - combustivel da Maquina 1; 5 - Combustivel da Maquina 2
-bool combustivel_1_disponivel = true;
-bool combustivel_2_disponivel = true;
-int combustivel_maq1 = COMBUSTIVEL_MAX;
-int combustivel_maq2 = COMBUSTIVEL_MAX;
+mapa_t mapa;
+
+// Estado do jogo. Só é alterado no núcleo 0 com o lock do lwIP (comandos da rede e temporizadores
+// da roda, atendidos no loop principal), então quem o altera nunca espera e quem o lê ali sempre
+// vê um estado consistente. O núcleo 1 não lê este estado: recebe uma cópia inteira dentro de
+// cada quadro. Toda alteração incrementa versao, e o loop principal publica um quadro novo
+// quando ela muda.
+typedef struct {
+    int robo_x, robo_y;              // Coordenadas do Robo
+    uint combustivel_robo;           // 0 - Nenhum; 4 - combustivel da Maquina 1; 5 - Combustivel da Maquina 2
+    bool combustivel_1_disponivel;
+    bool combustivel_2_disponivel;
+    int combustivel_maq1;
+    int combustivel_maq2;
+    bool intruso_detectado;          // Presença do intruso
+    uint32_t versao;                 // Incrementada a cada alteração
+} mundo_t;
+
+static mundo_t mundo = {
+    .robo_x = 2,
+    .robo_y = 2,
+    .combustivel_1_disponivel = true,
+    .combustivel_2_disponivel = true,
+    .combustivel_maq1 = COMBUSTIVEL_MAX,
+    .combustivel_maq2 = COMBUSTIVEL_MAX,
+};
 
-// Presença do intruso
-bool intruso_detectado = false;
+// Função para registrar uma alteração do estado do jogo (o próximo quadro a mostra)
+static inline void mundo_alterado(void) {
+    mundo.versao++;
+}
 
 // Variáveis para controlar o piscar do LED RGB sem bloquear o programa com sleep
 uint32_t led_gpio = 0;           // Pino GPIO que está conectado ao LED
-uint32_t led_duracao = 0;        // Duração de cada estado (ligado/desligado) em milissegundos
 uint32_t led_repeticoes = 0;     // Número de mudanças de estado restantes (liga/desliga alternado)
-uint32_t contador = 0;           // Próximo momento em que o LED deve mudar de estado (em ms)
+temporizador_t led_temporizador; // Troca o estado do LED a cada duração
+
+// Temporizadores do jogo (na roda de lib/temporizador, atendida pelo loop principal)
+static temporizador_t consumo_temporizador;   // Consumo de combustível das máquinas
+static temporizador_t recarga_1_temporizador; // Respawn do combustível 1
+static temporizador_t recarga_2_temporizador; // Respawn do combustível 2
+
+// Função para o relógio da roda de temporizadores (ms desde o boot)
+static uint32_t relogio_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+// O loop principal dorme até o próximo temporizador ou até chegar trabalho
+#define LACO_ESPERA_MAX_MS 1000  // Salvaguarda: acorda ao menos uma vez por segundo
+
+// Medidas do loop principal (exibidas em /stats)
+typedef struct {
+    uint32_t acordadas;          // Vezes em que o loop acordou
+    uint32_t prazos;             // Acordadas para atender um prazo
+    uint64_t atraso_soma_us;     // Soma dos atrasos entre o prazo e o despertar
+    uint32_t atraso_max_us;
+} laco_stats_t;
+
+static laco_stats_t laco_stats;
+
+// Histogramas de tempo do núcleo 0 (exibidos em /metrics); as rotas são as de lib/http, e a
+// posição NUM_ROTAS ao fim do vetor fica para requisições sem rota (404, 400, 431)
+#define METRICAS_ROTAS 16
+typedef struct {
+    histograma_t laco;                    // Trabalho de uma volta do loop principal, sem a espera
+    histograma_t atualiza_leds;           // Montagem e publicação de um quadro
+    histograma_t rotas[METRICAS_ROTAS];   // Da requisição lida à resposta entregue ao lwIP
+} metricas_t;
+
+// Histogramas do núcleo 1 (único escritor deles)
+typedef struct {
+    histograma_t npwrite;                 // Codificação e início do envio à matriz de LEDs
+    histograma_t display;                 // Cópia da janela alterada e início da DMA do display
+} metricas_nucleo1_t;
+
+static metricas_t metricas;
+static metricas_nucleo1_t metricas_nucleo1;
+
+void acorda_laco(void); // Acorda o loop principal (pode ser chamada de interrupções e alarmes)
 
 
 // Função para iniciar o processo de piscar o LED
@@ -101,186 +172,352 @@ void pisca_led(uint gpio, uint duracao_ms, uint repeticoes){
     gpio_put(BLUE_PIN, false);
 
     led_gpio = gpio;
-    led_duracao = duracao_ms;
     led_repeticoes = (repeticoes * 2) - 1; // Cada piscar tem 2 estados(ligado e desligado); subtrai 1 pois o primeiro liga já agora
-    contador = to_ms_since_boot(get_absolute_time()) + duracao_ms; // Define o próximo tempo para troca de estado
+    temporizador_agenda(&led_temporizador, duracao_ms, duracao_ms); // Troca de estado a cada duracao_ms
 
     gpio_put(led_gpio, true);
 }
 
-// Função de atualização do estado do led (Deve ser chamada frequentemente na main)
-void led_update(){
-    uint32_t agora = to_ms_since_boot(get_absolute_time());
-
-    if(led_repeticoes && agora >= contador){                 // Se ainda há repetições e chegou a hora de trocar
-        contador = agora + led_duracao;                      // Atualiza o próximo tempo para mudança de estado
+// Função de callback do temporizador do LED: troca o estado até acabarem as repetições
+static void led_alterna(temporizador_t *t){
+    led_repeticoes--;
+    if(led_repeticoes % 2 == 1) gpio_put(led_gpio, true);   // Se ímpar, liga o LED
+    else gpio_put(led_gpio, false);                         // Se par, desliga o LED
 
-        led_repeticoes--;                            
-        if(led_repeticoes % 2 == 1) gpio_put(led_gpio, true);   // Se ímpar, liga o LED
-        else gpio_put(led_gpio, false);                         // Se par, desliga o LED
-    }
+    if(!led_repeticoes) temporizador_cancela(t);
 }
 
 // Função para movimentar o robô na fábrica
 void move_robo(int x, int y) {
-    int novo_x = robo_x + x;
-    int novo_y = robo_y + y;
-
-    //Verifica se não está no limite do mapa
-    if (novo_x >= 0 && novo_x < MAPA_TAM && novo_y >= 0 && novo_y < MAPA_TAM && mapa[novo_y][novo_x] == VAZIO) {
-        robo_x = novo_x;
-        robo_y = novo_y;
+    int novo_x = mundo.robo_x + x;
+    int novo_y = mundo.robo_y + y;
+
+    // A borda do mapa é de obstáculos, então o limite do mapa é verificado junto com a célula
+    if (mapa_get(&mapa, novo_x, novo_y) == VAZIO) {
+        mundo.robo_x = novo_x;
+        mundo.robo_y = novo_y;
+        mundo_alterado();
     } else {
         beep(1000, 200, 2);
         pisca_led(RED_PIN, 200, 2);
     }
 }
 
-// Função para tentar criar uma linha entre 2 pontos e detectar se há um obstáculos entre eles
-bool tem_obstaculo_entre(int x1, int y1, int x2, int y2) {
-     // Calcula as diferenças absolutas entre os pontos
-    int dx = abs(x2 - x1);
-    int dy = abs(y2 - y1);
-
-    // Define o sentido do deslocamento nos eixos X e Y
-    int sx = x1 < x2 ? 1 : -1;  // Se x2 > x1, anda para direita; senão, esquerda
-    int sy = y1 < y2 ? 1 : -1;  // Se y2 > y1, anda para baixo; senão, cima
+//====================================
+//      Cache de Visibilidade
+//====================================
 
-    // Inicializa o erro da linha (diferença entre os eixos)
-    int err = dx - dy;
+// A visibilidade só depende da posição do robô e de onde estão os obstáculos. O campo de visão
+// do mapa inteiro é calculado por shadowcasting (lib/fov) e guardado em um bitmap (1 bit por
+// célula) por posição do robô, em uma cache mapeada diretamente com poucas entradas. Os bitmaps
+// são invalidados apenas quando uma célula de obstáculo muda (mapa.versao_obstaculos); a busca
+// por intrusos visíveis é refeita apenas quando alguma célula muda (mapa.versao_celulas).
+#define VIS_CACHE_ENTRADAS 4     // Deve ser potência de 2
+
+typedef struct {
+    int x, y;                    // Posição do robô para a qual o bitmap foi calculado
+    uint32_t versao;             // Versão dos obstáculos usada no cálculo (0 = entrada vazia)
+    uint32_t versao_celulas;     // Versão das células usada na busca por intrusos
+    bool intruso;                // Há algum intruso visível a partir de (x, y)
+    uint32_t *bits;              // Bit (y * largura + x) ligado = célula visível
+} vis_cache_t;
+
+static vis_cache_t vis_cache[VIS_CACHE_ENTRADAS];
+static fov_t fov;
+
+// Função para calcular a origem da janela em um eixo, centrada no robô e presa às bordas do mapa
+static inline int viewport_origem(int robo, int tamanho) {
+    int origem = robo - VIEWPORT_TAM / 2;
+    if (origem > tamanho - VIEWPORT_TAM) origem = tamanho - VIEWPORT_TAM;
+    if (origem < 0) origem = 0;
+    return origem;
+}
 
-    while (true) {
-        // Verifica obstáculo antes de qualquer movimento
-        if (mapa[y1][x1] == OBSTACULO) return true; // Retorna verdadeiro se houver um obstaculo
-        
-        // Se cheguei no ponto final, paro
-        if (x1 == x2 && y1 == y2) break;
+// Função para alocar a área do campo de visão e os bitmaps da cache para o mapa carregado
+bool visibilidade_init() {
+    if (!fov_init(&fov, &mapa)) return false;
 
-        // Calcula erro acumulado
-        int e2 = 2 * err;
-        
-        // Decide se move no eixo X
-        if (e2 > -dy) {
-            err -= dy;
-            x1 += sx;
-        }
+    for (int i = 0; i < VIS_CACHE_ENTRADAS; i++) {
+        vis_cache[i].versao = 0;
+        vis_cache[i].bits = malloc(fov.palavras * sizeof(uint32_t));
+        if (!vis_cache[i].bits) return false;
+    }
+    return true;
+}
 
-        // Decide se move no eixo Y
-        if (e2 < dx) {
-            err += dx;
-            y1 += sy;
+// Função para procurar um intruso entre as células visíveis, pulando palavras sem células visíveis
+static bool procura_intruso(const uint32_t *bits) {
+    for (uint32_t w = 0; w < fov.palavras; w++) {
+        uint32_t palavra = bits[w];
+        while (palavra) {
+            uint32_t i = (w << 5) + __builtin_ctz(palavra);
+            palavra &= palavra - 1;
+            if (mapa_get(&mapa, i % mapa.largura, i / mapa.largura) == INTRUSO) return true;
         }
     }
-    
-    // Não encontrou obstáculo no caminho
     return false;
 }
 
-bool atualiza_leds_flag = false; // Para sinalizar quando é preciso atualizar a matriz de leds
+// Função para obter a visibilidade a partir de (x, y), calculando apenas em caso de falta
+const vis_cache_t *visibilidade(int x, int y) {
+    vis_cache_t *e = &vis_cache[(y * mapa.largura + x) & (VIS_CACHE_ENTRADAS - 1)];
 
-// Função para atualizar a matriz de leds
-void atualiza_leds() {
+    if (e->versao != mapa.versao_obstaculos || e->x != x || e->y != y) {
+        fov_calcula(&fov, &mapa, x, y, e->bits);
+        e->x = x;
+        e->y = y;
+        e->versao = mapa.versao_obstaculos;
+        e->versao_celulas = 0;
+    }
+    if (e->versao_celulas != mapa.versao_celulas) {
+        e->intruso = procura_intruso(e->bits);
+        e->versao_celulas = mapa.versao_celulas;
+    }
+    return e;
+}
 
-     atualiza_leds_flag = false;
+static uint32_t versao_publicada; // Versão do estado do jogo no último quadro publicado
 
-    for (int y = 0; y < MAPA_TAM; y++) {
-        for (int x = 0; x < MAPA_TAM; x++) {
-            uint8_t r = 0, g = 0, b = 0;
-            bool visivel = true; // Assume-se que o objeto é visível inicialmente
+// Função para saber se o estado do jogo mudou desde o último quadro
+static inline bool mundo_pendente(void) {
+    return mundo.versao != versao_publicada;
+}
 
-            // Verifica se há obstáculos entre o robô e a célula atual
-            if (mapa[y][x] != OBSTACULO && tem_obstaculo_entre(robo_x, robo_y, x, y)) {
-                visivel = false;  // Não será visível se houver obstáculo entre
-            }
+void sse_publica(); // Envia as mudanças de estado aos clientes de /events (Funções do Web Server)
+
+//====================================
+//      Renderização (Núcleo 1)
+//====================================
+
+// O núcleo 0 (rede e lógica do jogo) monta um quadro imutável com tudo o que a matriz de LEDs e
+// o display mostram e o publica numa fila SPSC; o núcleo 1 desenha o quadro mais novo e envia
+// para os periféricos. Um envio lento ao display nunca atrasa uma resposta HTTP.
+typedef struct {
+    uint8_t celulas[VIEWPORT_TAM][VIEWPORT_TAM]; // Célula de cada LED da janela (VAZIO se não visível)
+    int8_t robo_vx, robo_vy;                     // Posição do robô na janela
+    mundo_t mundo;                               // Cópia do estado do jogo no momento do quadro
+} quadro_t;
+
+#define QUADROS_FILA 8         // Quadros na fila entre os núcleos (potência de 2)
+#define DISPLAY_REPETE_US 2000 // Nova tentativa de envio ao display enquanto a DMA está ocupada
+
+static quadro_t quadros[QUADROS_FILA];
+static spsc_t fila_quadros;
+
+// Contadores da renderização (exibidos em /stats)
+typedef struct {
+    uint32_t publicados;            // Quadros montados pelo núcleo 0
+    uint32_t fila_cheia;            // Quadros adiados por falta de espaço na fila
+    volatile uint32_t desenhados;   // Quadros desenhados pelo núcleo 1
+    volatile uint32_t descartados;  // Quadros substituídos por um mais novo antes de desenhar
+    volatile uint32_t display;      // Envios ao display
+} render_stats_t;
+
+static render_stats_t render_stats;
+
+// Função para desenhar o quadro na matriz de LEDs (núcleo 1)
+static void desenha_matriz(const quadro_t *q) {
+    for (int vy = 0; vy < VIEWPORT_TAM; vy++) {
+        for (int vx = 0; vx < VIEWPORT_TAM; vx++) {
+            uint8_t r = 0, g = 0, b = 0;
+            uint8_t celula = q->celulas[vy][vx];
 
-            if (x == robo_x && y == robo_y) {
+            if (vx == q->robo_vx && vy == q->robo_vy) {
                 // Desenha o robô, cor cinza
                 r = 1; g = 1; b = 1;
             }
-            else if (mapa[y][x] == OBSTACULO && visivel) {
+            else if (celula == OBSTACULO) {
                 // Desenha o obstáculo, cor branca
                 r = 10; g = 10; b = 10;
             }
-            else if (mapa[y][x] == MAQUINA_1 && visivel) {
+            else if (celula == MAQUINA_1) {
                 // Desenha a máquina 2, cor laranja se combustivel for 2, amarelo se for 1, e amarelo apagado se for 0                
-                if (combustivel_maq1 == COMBUSTIVEL_MAX) { 
+                if (q->mundo.combustivel_maq1 == COMBUSTIVEL_MAX) { 
                     r = 13 ; g = 2; b = 0; // Laranja
-                } else if (combustivel_maq1 == 1) { 
+                } else if (q->mundo.combustivel_maq1 == 1) { 
                     r = 20 ; g = 20; b = 0; // Amarelo
                 } else {
                     r = 1; g = 1; b = 0; // Amarelo apagado
                 }
             }
-            else if (mapa[y][x] == MAQUINA_2 && visivel) {
+            else if (celula == MAQUINA_2) {
                 // Desenha a máquina 2, cor laranja se combustivel for 2, amarelo se for 1, e amarelo apagado se for 0
-                if (combustivel_maq2 == COMBUSTIVEL_MAX) { 
+                if (q->mundo.combustivel_maq2 == COMBUSTIVEL_MAX) { 
                     r = 13 ; g = 2; b = 0; // Laranja
-                } else if (combustivel_maq2 == 1) { 
+                } else if (q->mundo.combustivel_maq2 == 1) { 
                     r = 20 ; g = 20; b = 0; // Amarelo
                 } else {
                     r = 1; g = 1; b = 0; // Amarelo apagado
                 }
             }
 
-            else if (mapa[y][x] == COMBUSTIVEL_1 && visivel) {
+            else if (celula == COMBUSTIVEL_1) {
                 // Desenha a carga do combustivel 1, cor violeta (ligada ou desligada)
-                if (combustivel_1_disponivel) {
+                if (q->mundo.combustivel_1_disponivel) {
                     r = 20; g = 0; b = 20; // Mais clara quando ligada
                 } else {
                     r = 1; g = 0; b = 1; // Mais escura quando desligada
                 }
             }
 
-            else if (mapa[y][x] == COMBUSTIVEL_2 && visivel) {
+            else if (celula == COMBUSTIVEL_2) {
                 // Desenha a carga do combustivel 2, cor violeta (ligada ou desligada)
-                if (combustivel_2_disponivel) {
+                if (q->mundo.combustivel_2_disponivel) {
                     r = 20; g = 0; b = 20; // Mais clara quando ligada
                 } else {
                     r = 1; g = 0; b = 1; // Mais escura quando desligada
                 }
             }
-            else if (mapa[y][x] == INTRUSO && visivel) {
+            else if (celula == INTRUSO) {
                 // Desenha o intruso, cor vermelha
                 r = 20; g = 0; b = 0;
-                intruso_detectado = true;
             }
 
-            // Atualiza o LED na posição x, y com a cor calculada
-            int y_invertido = (MAPA_TAM - 1) - y;
-            int index = npGetIndex(x, y_invertido);
+            // Atualiza o LED na posição vx, vy da janela com a cor calculada
+            int y_invertido = (VIEWPORT_TAM - 1) - vy;
+            int index = npGetIndex(vx, y_invertido);
             npSetLED(index, r, g, b);
         }
     }
+
+    uint32_t inicio = time_us_32();
     npWrite();
+    histograma_registra(&metricas_nucleo1.npwrite, time_us_32() - inicio);
+}
+
+// Função para desenhar o painel de estado no display (núcleo 1); só redesenha se algo mostrado
+// mudou, e só as colunas alteradas são enviadas
+static void desenha_display(const quadro_t *q) {
+    static quadro_t anterior;
+    static bool desenhado = false;
+    char linha[17];
+
+    if (desenhado && q->mundo.robo_x == anterior.mundo.robo_x && q->mundo.robo_y == anterior.mundo.robo_y &&
+        q->mundo.combustivel_maq1 == anterior.mundo.combustivel_maq1 && q->mundo.combustivel_maq2 == anterior.mundo.combustivel_maq2 &&
+        q->mundo.combustivel_robo == anterior.mundo.combustivel_robo && q->mundo.intruso_detectado == anterior.mundo.intruso_detectado) {
+        return;
+    }
+    anterior = *q;
+    desenhado = true;
+
+    ssd1306_fill(&ssd, false);
+    ssd1306_draw_string(&ssd, "Servidor Ativo", 0, 0);
+    snprintf(linha, sizeof(linha), "Pos: (%d, %d)", q->mundo.robo_x, q->mundo.robo_y);
+    ssd1306_draw_string(&ssd, linha, 0, 16);
+    snprintf(linha, sizeof(linha), "Comb: %s", (q->mundo.combustivel_robo == COMBUSTIVEL_1) ? "Tipo 1" :
+                                               (q->mundo.combustivel_robo == COMBUSTIVEL_2) ? "Tipo 2" : "Nenhum");
+    ssd1306_draw_string(&ssd, linha, 0, 28);
+    snprintf(linha, sizeof(linha), "M1 %d/2  M2 %d/2", q->mundo.combustivel_maq1, q->mundo.combustivel_maq2);
+    ssd1306_draw_string(&ssd, linha, 0, 40);
+    ssd1306_draw_string(&ssd, q->mundo.intruso_detectado ? "INTRUSO!" : "Sem intruso", 0, 52);
+    render_stats.display++;
+}
+
+// Laço do núcleo 1: dorme na FIFO entre os núcleos até o núcleo 0 tocar a campainha de um
+// quadro novo. Quadros acumulados são descartados: só o mais novo é desenhado.
+static void core1_main(void) {
+    while (true) {
+        uint32_t campainha;
+        uint32_t inicio = time_us_32();
+        bool enviado = ssd1306_send_data_async(&ssd);
+
+        // Só conta os envios que de fato começaram (a DMA continua sozinha depois daqui)
+        if (enviado && ssd1306_flush_busy(&ssd)) histograma_registra(&metricas_nucleo1.display, time_us_32() - inicio);
+        if (enviado) multicore_fifo_pop_blocking();
+        else multicore_fifo_pop_timeout_us(DISPLAY_REPETE_US, &campainha); // Display ocupado: tenta de novo
+
+        int i;
+        while ((i = spsc_proximo(&fila_quadros)) >= 0) {
+            if (spsc_quantidade(&fila_quadros) == 1) {
+                trace_registra(TRACE_RENDER_INICIO, 0);
+                desenha_matriz(&quadros[i]);
+                desenha_display(&quadros[i]);
+                trace_registra(TRACE_RENDER_FIM, 0);
+                render_stats.desenhados++;
+            } else {
+                render_stats.descartados++;
+            }
+            spsc_consome(&fila_quadros);
+        }
+    }
+}
+
+// Função para atualizar a matriz de leds: monta o quadro com o estado atual e o entrega ao
+// núcleo 1 (núcleo 0, com o lock do lwIP)
+void atualiza_leds() {
+    uint32_t inicio = time_us_32();
+
+    // Campo de visão a partir da posição atual do robô (consulta à cache)
+    const vis_cache_t *vis = visibilidade(mundo.robo_x, mundo.robo_y);
+    if (vis->intruso && !mundo.intruso_detectado) {
+        mundo.intruso_detectado = true;
+        mundo_alterado();
+    }
+
+    int i = spsc_reserva(&fila_quadros);
+    if (i < 0) {
+        // O núcleo 1 ainda não consumiu os quadros anteriores: versao_publicada fica para trás
+        // e o loop principal tenta de novo na próxima volta
+        render_stats.fila_cheia++;
+        sse_publica();
+        return;
+    }
+    quadro_t *q = &quadros[i];
+
+    // Janela do mapa exibida na matriz, acompanhando o robô
+    int ox = viewport_origem(mundo.robo_x, mapa.largura);
+    int oy = viewport_origem(mundo.robo_y, mapa.altura);
+
+    for (int vy = 0; vy < VIEWPORT_TAM; vy++) {
+        for (int vx = 0; vx < VIEWPORT_TAM; vx++) {
+            int x = ox + vx, y = oy + vy;
+            uint8_t celula = VAZIO;
+
+            if (mapa_dentro(&mapa, x, y)) {
+                celula = mapa_get(&mapa, x, y);
+                // Obstáculos são sempre desenhados; as demais células dependem do campo de visão
+                if (celula != OBSTACULO && !fov_visivel(vis->bits, &mapa, x, y)) celula = VAZIO;
+            }
+            q->celulas[vy][vx] = celula;
+        }
+    }
+    q->robo_vx = mundo.robo_x - ox;
+    q->robo_vy = mundo.robo_y - oy;
+    q->mundo = mundo;
+
+    spsc_publica(&fila_quadros);
+    render_stats.publicados++;
+    versao_publicada = mundo.versao;
+
+    // Campainha para o núcleo 1; com a FIFO cheia ele já tem campainhas a atender
+    if (multicore_fifo_wready()) multicore_fifo_push_blocking(0);
+
+    sse_publica();
+    histograma_registra(&metricas.atualiza_leds, time_us_32() - inicio);
 }
 
 // Função de callback para diminuir o combustivel das maquinas
-bool consome_combustivel(struct repeating_timer *t){
+void consome_combustivel(temporizador_t *t){
 
-    if(combustivel_maq1 > 0) combustivel_maq1 -= 1;
-    if(combustivel_maq2 > 0) combustivel_maq2 -= 1;
+    if(mundo.combustivel_maq1 > 0) mundo.combustivel_maq1 -= 1;
+    if(mundo.combustivel_maq2 > 0) mundo.combustivel_maq2 -= 1;
 
-    atualiza_leds_flag = true;
-    
+    mundo_alterado();
 }
 
-//Alarmes para recarregar um combustivel especifico
-int64_t recarrega_combustivel_1(alarm_id_t id, void *user_data) {
+//Temporizadores para recarregar um combustivel especifico
+void recarrega_combustivel_1(temporizador_t *t) {
     
-    combustivel_1_disponivel = true;
+    mundo.combustivel_1_disponivel = true;
     printf("Combustivel 1 foi recarregado\n");
-    atualiza_leds_flag = true;
-    
-    return 0;  // Não repetirá o alarme
+    mundo_alterado();
 }
 
-int64_t recarrega_combustivel_2(alarm_id_t id, void *user_data) {
+void recarrega_combustivel_2(temporizador_t *t) {
     
-    combustivel_2_disponivel = true;
+    mundo.combustivel_2_disponivel = true;
     printf("Combustivel 2 foi recarregado\n");
-    atualiza_leds_flag = true;
-    
-    return 0;  // Não repetirá o alarme
+    mundo_alterado();
 }
 
 // Função para entregar e coletar o combustivel por um dos lados(cima, baixo, esquerda ou direita) e configurar o alarme para desligamento
@@ -298,47 +535,46 @@ void entrega_combustivel(int x, int y) {
         int adj_x = adjacentes[i][0];  // Coordenada X da posição adjacente
         int adj_y = adjacentes[i][1];  // Coordenada Y da posição adjacente
 
-        // Primeiro verifica se a posição adjacente está dentro dos limites do mapa
-        if (adj_x >= 0 && adj_x < MAPA_TAM && adj_y >= 0 && adj_y < MAPA_TAM) {
+        // Vizinhos fora do mapa caem na borda de obstáculos, sem necessidade de verificar limites
+        uint8_t celula = mapa_get(&mapa, adj_x, adj_y);
+
+        // Caso 1: Verifica se há uma Máquina 1 na posição adjacente
+        if (celula == MAQUINA_1) {
             
-            // Caso 1: Verifica se há uma Máquina 1 na posição adjacente
-            if (mapa[adj_y][adj_x] == MAQUINA_1) {
-                
-                // Se a máquina já está cheia ou o robô não tem o combustível correto
-                if (combustivel_maq1 >= COMBUSTIVEL_MAX || combustivel_robo != COMBUSTIVEL_1) {
-                    printf("Combustivel da Maquina 1 cheio ou combustivel inválido\n");
-                    beep(1000, 200, 2);            // Feedback sonoro de erro
-                    pisca_led(RED_PIN, 200, 2);     // Feedback visual de erro
-                }
-                // Caso contrário, realiza a entrega do combustível
-                else {
-                    printf("Combustivel inserido na Maquina 1.\n");
-                    combustivel_maq1 += 1;         // Incrementa o combustível da máquina
-                    combustivel_robo = 0;           // Esvazia o combustível do robô
-                    atualiza_leds_flag = true;      // Sinaliza para atualizar a matriz de LEDs
-                    beep(2000, 200, 3);            // Feedback sonoro de sucesso
-                    pisca_led(GREEN_PIN, 200, 3);  // Feedback visual de sucesso
-                }
+            // Se a máquina já está cheia ou o robô não tem o combustível correto
+            if (mundo.combustivel_maq1 >= COMBUSTIVEL_MAX || mundo.combustivel_robo != COMBUSTIVEL_1) {
+                printf("Combustivel da Maquina 1 cheio ou combustivel inválido\n");
+                beep(1000, 200, 2);            // Feedback sonoro de erro
+                pisca_led(RED_PIN, 200, 2);     // Feedback visual de erro
             }
+            // Caso contrário, realiza a entrega do combustível
+            else {
+                printf("Combustivel inserido na Maquina 1.\n");
+                mundo.combustivel_maq1 += 1;         // Incrementa o combustível da máquina
+                mundo.combustivel_robo = 0;           // Esvazia o combustível do robô
+                mundo_alterado();              // Sinaliza para atualizar a matriz de LEDs
+                beep(2000, 200, 3);            // Feedback sonoro de sucesso
+                pisca_led(GREEN_PIN, 200, 3);  // Feedback visual de sucesso
+            }
+        }
+        
+        // Caso 2: Verifica se há uma Máquina 2 na posição adjacente
+        else if (celula == MAQUINA_2) {
             
-            // Caso 2: Verifica se há uma Máquina 2 na posição adjacente
-            else if (mapa[adj_y][adj_x] == MAQUINA_2) {
-                
-                // Se a máquina já está cheia ou o robô não tem o combustível correto
-                if (combustivel_maq2 >= COMBUSTIVEL_MAX || combustivel_robo != COMBUSTIVEL_2) {
-                    printf("Combustivel da Maquina 2 cheio.\n");
-                    beep(1000, 200, 2);            // Feedback sonoro de erro
-                    pisca_led(RED_PIN, 200, 2);    // Feedback visual de erro
-                }
-                // Caso contrário, realiza a entrega do combustível
-                else {
-                    printf("Combustivel inserido na Maquina 2.\n");
-                    combustivel_maq2 += 1;         // Incrementa o combustível da máquina
-                    combustivel_robo = 0;           // Esvazia o combustível do robô
-                    atualiza_leds_flag = true;      // Sinaliza para atualizar a matriz de LEDs
-                    beep(2000, 200, 3);            // Feedback sonoro de sucesso
-                    pisca_led(GREEN_PIN, 200, 3);  // Feedback visual de sucesso
-                }
+            // Se a máquina já está cheia ou o robô não tem o combustível correto
+            if (mundo.combustivel_maq2 >= COMBUSTIVEL_MAX || mundo.combustivel_robo != COMBUSTIVEL_2) {
+                printf("Combustivel da Maquina 2 cheio.\n");
+                beep(1000, 200, 2);            // Feedback sonoro de erro
+                pisca_led(RED_PIN, 200, 2);    // Feedback visual de erro
+            }
+            // Caso contrário, realiza a entrega do combustível
+            else {
+                printf("Combustivel inserido na Maquina 2.\n");
+                mundo.combustivel_maq2 += 1;         // Incrementa o combustível da máquina
+                mundo.combustivel_robo = 0;           // Esvazia o combustível do robô
+                mundo_alterado();              // Sinaliza para atualizar a matriz de LEDs
+                beep(2000, 200, 3);            // Feedback sonoro de sucesso
+                pisca_led(GREEN_PIN, 200, 3);  // Feedback visual de sucesso
             }
         }
     }
@@ -358,43 +594,42 @@ void coleta_combustivel(int x, int y) {
         int adj_x = adjacentes[i][0];  // Coordenada X da posição adjacente
         int adj_y = adjacentes[i][1];  // Coordenada Y da posição adjacente
 
-        // Primeiro verifica se a posição adjacente está dentro dos limites do mapa
-        if (adj_x >= 0 && adj_x < MAPA_TAM && adj_y >= 0 && adj_y < MAPA_TAM) {
+        // Vizinhos fora do mapa caem na borda de obstáculos, sem necessidade de verificar limites
+        uint8_t celula = mapa_get(&mapa, adj_x, adj_y);
+
+        // Verifica se há um depósito de combustível (tipo 1 ou 2) na posição
+        if (celula == COMBUSTIVEL_1 || celula == COMBUSTIVEL_2) {
             
-            // Verifica se há um depósito de combustível (tipo 1 ou 2) na posição
-            if (mapa[adj_y][adj_x] == COMBUSTIVEL_1 || mapa[adj_y][adj_x] == COMBUSTIVEL_2) {
-                
-                // Se o robô já está carregando combustível (não pode coletar outro)
-                if (combustivel_robo != 0) {
-                    printf("Robô já possui combustivel\n");
-                    beep(1000, 200, 2);         // Feedback sonoro de erro
-                    pisca_led(RED_PIN, 200, 2); // Feedback visual de erro
+            // Se o robô já está carregando combustível (não pode coletar outro)
+            if (mundo.combustivel_robo != 0) {
+                printf("Robô já possui combustivel\n");
+                beep(1000, 200, 2);         // Feedback sonoro de erro
+                pisca_led(RED_PIN, 200, 2); // Feedback visual de erro
+            }
+            // Se o robô está vazio e pode coletar
+            else {
+                // Caso 1: Combustível tipo 1 disponível
+                if (celula == COMBUSTIVEL_1 && mundo.combustivel_1_disponivel) {
+                    mundo.combustivel_1_disponivel = false;   // Marca como coletado
+                    mundo.combustivel_robo = COMBUSTIVEL_1;    // Carrega no robô
+                    
+                    // Programa o respawn após 3 segundos
+                    temporizador_agenda(&recarga_1_temporizador, 3000, 0);
                 }
-                // Se o robô está vazio e pode coletar
-                else {
-                    // Caso 1: Combustível tipo 1 disponível
-                    if (mapa[adj_y][adj_x] == COMBUSTIVEL_1 && combustivel_1_disponivel) {
-                        combustivel_1_disponivel = false;   // Marca como coletado
-                        combustivel_robo = COMBUSTIVEL_1;    // Carrega no robô
-                        
-                        // Programa o respawn após 3 segundos
-                        add_alarm_in_ms(3000, recarrega_combustivel_1, NULL, false);
-                    }
-                    // Caso 2: Combustível tipo 2 disponível
-                    else if (mapa[adj_y][adj_x] == COMBUSTIVEL_2 && combustivel_2_disponivel) {
-                        combustivel_2_disponivel = false;   // Marca como coletado
-                        combustivel_robo = COMBUSTIVEL_2;    // Carrega no robô
-                        
-                        // Programa o respawn após 3 segundos
-                        add_alarm_in_ms(3000, recarrega_combustivel_2, NULL, false);
-                    }
-
-                    // Feedback de sucesso
-                    printf("Robô coletou combustível\n");
-                    atualiza_leds_flag = true;     // Sinaliza para atualizar LEDs
-                    beep(2000, 200, 3);          // Feedback sonoro de sucesso
-                    pisca_led(GREEN_PIN, 200, 3); // Feedback visual de sucesso
+                // Caso 2: Combustível tipo 2 disponível
+                else if (celula == COMBUSTIVEL_2 && mundo.combustivel_2_disponivel) {
+                    mundo.combustivel_2_disponivel = false;   // Marca como coletado
+                    mundo.combustivel_robo = COMBUSTIVEL_2;    // Carrega no robô
+                    
+                    // Programa o respawn após 3 segundos
+                    temporizador_agenda(&recarga_2_temporizador, 3000, 0);
                 }
+
+                // Feedback de sucesso
+                printf("Robô coletou combustível\n");
+                mundo_alterado();            // Sinaliza para atualizar LEDs
+                beep(2000, 200, 3);          // Feedback sonoro de sucesso
+                pisca_led(GREEN_PIN, 200, 3); // Feedback visual de sucesso
             }
         }
     }
@@ -414,15 +649,13 @@ void captura_intruso(int x, int y){
         int adj_x = adjacentes[i][0];
         int adj_y = adjacentes[i][1];
 
-        // Verifica se a posição adjacente está dentro dos limites do mapa
-        if (adj_x >= 0 && adj_x < MAPA_TAM && adj_y >= 0 && adj_y < MAPA_TAM) {
-            if(mapa[adj_y][adj_x] == INTRUSO){
-                mapa[adj_y][adj_x] = VAZIO;
-                intruso_detectado = false;
-                beep(2000, 200, 3);
-                pisca_led(GREEN_PIN, 200, 3);
-                atualiza_leds_flag = true;
-            }
+        // Vizinhos fora do mapa caem na borda de obstáculos, sem necessidade de verificar limites
+        if(mapa_get(&mapa, adj_x, adj_y) == INTRUSO){
+            mapa_set(&mapa, adj_x, adj_y, VAZIO);
+            mundo.intruso_detectado = false;
+            beep(2000, 200, 3);
+            pisca_led(GREEN_PIN, 200, 3);
+            mundo_alterado();
         }
     }
 }
@@ -431,53 +664,17 @@ void captura_intruso(int x, int y){
 //      Funções do Web Server        
 //====================================
 
-char html[4096]; // Cria a resposta HTML
-
-// Função para gerir as requisições
-void user_request(char *request) {
-    if (strstr(request, "GET /up") != NULL) {
-        move_robo(0, -1);
-    } else if (strstr(request, "GET /down") != NULL) {
-        move_robo(0, 1);
-    } else if (strstr(request, "GET /left") != NULL) {
-        move_robo(-1, 0);
-    } else if (strstr(request, "GET /right") != NULL) {
-        move_robo(1, 0);
-    } else if (strstr(request, "GET /capturar") != NULL) {
-        captura_intruso(robo_x, robo_y);
-    } else if (strstr(request, "GET /entrega") != NULL) {
-        entrega_combustivel(robo_x, robo_y);
-    } else if (strstr(request, "GET /coleta") != NULL) {
-        coleta_combustivel(robo_x, robo_y);
-    }
-
-    atualiza_leds();
-}
-// Função de callback para processar requisições HTTP
-static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
-{
-    if (!p){
-        tcp_close(tpcb);
-        return ERR_OK;
-    }
-
-    // Alocação do request na memória dinámica
-    char *request = (char *)p->payload;
-
-    printf("Request: %s\n", request);
-
-    // Tratamento de request - Controle dos LEDs
-    user_request(request);
-    
-    // Instruções html do webserver
-    snprintf(html, sizeof(html),
+// A página é dividida em três partes: o início (CSS e script) e o fim (botões) nunca mudam e
+// ficam na flash (XIP), sendo entregues ao lwIP sem cópia, assim como os cabeçalhos fixos; só
+// o bloco de informações do meio e o Content-Length são formatados a cada requisição.
+static const char cabecalho_html[] =
     "HTTP/1.1 200 OK\r\n"
     "Content-Type: text/html; charset=utf-8\r\n"
     "Cache-Control: no-cache, no-store, must-revalidate\r\n"
     "Pragma: no-cache\r\n"
-    "Expires: 0\r\n"
-    "Connection: close\r\n"
-    "\r\n"
+    "Expires: 0\r\n";
+
+static const char pagina_inicio[] =
     "<!DOCTYPE html><html><head>"
     "<meta name='viewport' content='width=device-width,initial-scale=1'>"
     "<meta charset='UTF-8'>"
@@ -486,76 +683,1296 @@ static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, er
     ".info{padding:10px;margin:5px;background:#fff;border-radius:5px}"
     "button{border:0;border-radius:8px;padding:12px;margin:4px;font-size:1.1em}"
     ".ctrl{width:20vw;height:20vw;max-width:100px;max-height:100px;background:#ddd;color:#000}"
-    ".status{color:%s}"
     ".btn-vermelho{background:#f44336;color:white}"
     ".btn-amarelo{background:#ffeb3b;color:black}"
     ".btn-verde{background:#4CAF50;color:white}"      // Novo estilo para botão verde
     ".btn-azul{background:#2196F3;color:white}"       // Novo estilo para botão azul
     "</style></head>"
     "<script>"
-    "setInterval(function(){location.href='/';},3000);" // Scrpit para atualizar a página a cada 3 segundos
+    // Recebe as mudanças de estado por Server-Sent Events; sem suporte, recarrega a cada 3 segundos
+    "if(window.EventSource){"
+    "new EventSource('/events').onmessage=function(e){"
+    "var d=JSON.parse(e.data),q=function(i){return document.getElementById(i)};"
+    "if('maq1'in d)q('estado-maquina1').textContent=d.maq1+'/2';"
+    "if('maq2'in d)q('estado-maquina2').textContent=d.maq2+'/2';"
+    "if('intruso'in d){var t=q('estado-intruso');t.textContent=d.intruso?'DETECTADO':'NENHUM';t.style.color=d.intruso?'red':'green'}"
+    "if('x'in d)q('posicao').textContent='('+d.x+', '+d.y+')';"
+    "if('combustivel'in d)q('combustivel').textContent=['Nenhum','Tipo 1','Tipo 2'][d.combustivel];"
+    "}}else setInterval(function(){location.href='/';},3000);"
+    "</script>"
+    "<body><h1>ROBÔ VIGIA</h1>";
+
+static const char pagina_fim[] =
+    "<div style='margin:20px 0'>"
+    "<div><a href='/up' data-c='U'><button class='ctrl'>▲</button></a></div>"
+    "<div>"
+    "<a href='/left' data-c='L'><button class='ctrl'>◀</button></a>"
+    "<a href='/right' data-c='R'><button class='ctrl'>▶</button></a>"
+    "</div>"
+    "<div><a href='/down' data-c='D'><button class='ctrl'>▼</button></a></div>"
+    "</div>"
+
+    "<div style='margin-top:20px'>"
+    "<a href='/capturar' data-c='P'><button class='btn-vermelho'>Capturar Intruso</button></a>"
+    "</div>"
+
+    // Novos botões para combustível
+    "<div style='margin-top:20px'>"
+    "<a href='/entrega' data-c='E'><button class='btn-verde'>Entregar Combustível</button></a>"
+    "<a href='/coleta' data-c='C'><button class='btn-amarelo'>Coletar Combustível</button></a>"
+    "</div>"
+
+    // Com o WebSocket aberto os botões enviam comandos de 1 byte em vez de navegar; as setas
+    // repetem o comando a 20 Hz enquanto estiverem pressionadas (teclado: setas do teclado)
+    "<script>"
+    "var ws,rep,q=function(i){return document.getElementById(i)};"
+    "try{ws=new WebSocket('ws://'+location.host+'/ws');ws.binaryType='arraybuffer';"
+    "ws.onmessage=function(e){var b=new Uint8Array(e.data);if(b.length<6)return;"
+    "q('posicao').textContent='('+b[1]+', '+b[2]+')';"
+    "q('estado-maquina1').textContent=b[3]+'/2';q('estado-maquina2').textContent=b[4]+'/2';"
+    "var t=q('estado-intruso');t.textContent=b[5]&1?'DETECTADO':'NENHUM';t.style.color=b[5]&1?'red':'green';"
+    "q('combustivel').textContent=['Nenhum','Tipo 1','Tipo 2'][b[5]>>1];}}catch(e){}"
+    "function aberto(){return ws&&ws.readyState==1}"
+    "function envia(c){ws.send(new Uint8Array([c.charCodeAt(0)]))}"
+    "function solta(){clearInterval(rep);rep=0}"
+    "document.querySelectorAll('a[data-c]').forEach(function(a){var c=a.dataset.c,seta='UDLR'.indexOf(c)>=0;"
+    "a.onclick=function(e){if(!aberto())return;e.preventDefault();if(!seta)envia(c)};"
+    "if(seta){a.onpointerdown=function(){if(!aberto())return;solta();envia(c);rep=setInterval(function(){envia(c)},50)};"
+    "a.onpointerup=a.onpointerleave=a.onpointercancel=solta}});"
+    "document.onkeydown=function(e){var c={ArrowUp:'U',ArrowDown:'D',ArrowLeft:'L',ArrowRight:'R'}[e.key];"
+    "if(c&&aberto()){e.preventDefault();envia(c)}};"
     "</script>"
-    "<body><h1>ROBÔ VIGIA</h1>"
 
+    "</body></html>";
+
+static const char cabecalho_json[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Cache-Control: no-cache, no-store, must-revalidate\r\n";
+
+static const char cabecalho_sse[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static const char cabecalho_mapa[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; charset=utf-8\r\n"
+    "Cache-Control: no-cache\r\n";
+
+static const char cabecalho_metricas[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+    "Cache-Control: no-cache\r\n";
+
+static const char cabecalho_chunked[] = "Transfer-Encoding: chunked\r\n";
+static const char cabecalho_fim[] = "\r\n";
+static const char cabecalho_fim_close[] = "Connection: close\r\n\r\n";
+
+static const char cabecalho_ws[] =
+    "HTTP/1.1 101 Switching Protocols\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Accept: ";
+
+static const char resposta_invalida[] =
+    "HTTP/1.1 400 Bad Request\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static const char resposta_nao_encontrada[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+static const char resposta_uri_grande[] =
+    "HTTP/1.1 414 URI Too Long\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static const char resposta_grande[] =
+    "HTTP/1.1 431 Request Header Fields Too Large\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static const char resposta_ocupado[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+#define HTTP_DINAMICO_TAM 768 // Espaço para o bloco de informações formatado (ou o JSON de /stats)
+#define HTTP_EXTRA_TAM 64     // Início do buffer dinamico reservado ao Content-Length da resposta
+#define HTTP_POLL_INTERVALO 2 // tcp_poll a cada 2 x 500 ms
+#define HTTP_OCIOSA_MAX 10    // Conexões keep-alive sem atividade por ~10 s são fechadas
+#define HTTP_DESCARTE_MIN 2   // Só conexões sem atividade há ~2 s dão lugar a uma nova
+#define SSE_MAX_CLIENTES 4    // Conexões simultâneas em /events
+#define HTTP_MAX_CONEXOES 8   // Conexões simultâneas (menos que MEMP_NUM_TCP_PCB, ver lwipopts.h)
+#define COMANDOS_FILA 128     // Comandos à espera do loop principal (potência de 2, cabe um quadro WebSocket)
+
+// Sobram PCBs para as conexões em TIME_WAIT e para recusar novas conexões com um 503
+#if HTTP_MAX_CONEXOES >= MEMP_NUM_TCP_PCB
+#error "HTTP_MAX_CONEXOES deve ser menor que MEMP_NUM_TCP_PCB"
+#endif
+
+// /cmd?seq= com a fila inteira de comandos cabe na query guardada pelo parser
+#if HTTP_QUERY_MAX < COMANDOS_FILA + 4
+#error "HTTP_QUERY_MAX deve caber seq= e COMANDOS_FILA comandos"
+#endif
+
+// /metrics lê os contadores do lwIP
+#if !LWIP_STATS || !MEM_STATS || !MEMP_STATS || !LINK_STATS
+#error "/metrics precisa de LWIP_STATS, MEM_STATS, MEMP_STATS e LINK_STATS no lwipopts.h"
+#endif
+
+// Rotas do servidor, em ordem crescente de chave (exigência de lib/http). Os comandos usam a
+// própria letra do comando como identificador; 0 é reservado para rota desconhecida. A mesma
+// lista, na mesma ordem, dá nome às rotas em tools/trace2chrome.py.
+enum { ROTA_PAGINA = 1, ROTA_ESTADO, ROTA_EVENTOS, ROTA_MAPA, ROTA_WS, ROTA_STATS, ROTA_CMD, ROTA_METRICAS };
+
+static const http_rota_t rotas[] = {
+    { "GET /",         ROTA_PAGINA  },
+    { "GET /capturar", 'P'          },
+    { "GET /cmd",      ROTA_CMD     },
+    { "GET /coleta",   'C'          },
+    { "GET /down",     'D'          },
+    { "GET /entrega",  'E'          },
+    { "GET /events",   ROTA_EVENTOS },
+    { "GET /left",     'L'          },
+    { "GET /mapa",     ROTA_MAPA    },
+    { "GET /metrics",  ROTA_METRICAS },
+    { "GET /right",    'R'          },
+    { "GET /state",    ROTA_ESTADO  },
+    { "GET /stats",    ROTA_STATS   },
+    { "GET /up",       'U'          },
+    { "GET /ws",       ROTA_WS      },
+};
+#define NUM_ROTAS (sizeof(rotas) / sizeof(rotas[0]))
+
+_Static_assert(NUM_ROTAS < METRICAS_ROTAS, "METRICAS_ROTAS deve ter uma posição por rota e uma para rota desconhecida");
+
+// Estado de cada conexão HTTP
+typedef struct {
+    char dinamico[HTTP_DINAMICO_TAM]; // Referenciado pelo lwIP (sem cópia) até ser confirmado
+    saida_t saida;                    // Fila da resposta, escrita no ritmo das confirmações
+    uint32_t confirmado;              // Total de bytes confirmados pelo cliente
+    uint32_t dinamico_ate;            // Posição na saída do fim do último uso de dinamico
+    struct pbuf *rx;                  // Dados recebidos e ainda não processados
+    bool fim_recebido;                // O cliente fechou o seu lado da conexão
+    bool fechada;                     // Já foi fechada; libera quando tudo for confirmado
+    bool fechar;                      // Fecha depois de entregar a resposta atual
+    uint8_t ociosa;                   // Chamadas de tcp_poll sem atividade
+    int sse;                          // Índice em sse_clientes, ou -1
+    bool sse_completo;                // Um evento se perdeu: o próximo leva o estado completo
+    bool ws;                          // Conexão promovida a WebSocket em /ws
+    http_parser_t http;               // Estado do parser da requisição atual
+    uint16_t entrada_tam;             // Bytes de um quadro WebSocket ainda incompleto em entrada
+    char entrada[WS_QUADRO_MAX];
+    struct tcp_pcb *pcb;
+    bool usada;                       // Slot ocupado na tabela de conexões
+    uint8_t aguarda;                  // Resposta à espera dos comandos enfileirados (AGUARDA_*)
+    uint8_t ws_comando;               // Último comando do quadro WebSocket à espera
+    int8_t medida;                    // Rota da requisição em andamento em metricas.rotas, ou -1
+    uint32_t medida_inicio_us;        // Quando a requisição em andamento terminou de ser lida
+} conexao_t;
+
+// Respostas que dependem dos comandos enfileirados: saem depois que o loop principal os executa
+enum { AGUARDA_NADA, AGUARDA_PAGINA, AGUARDA_ESTADO, AGUARDA_WS };
+
+// Contadores da fila de comandos (exibidos em /stats)
+typedef struct {
+    uint32_t executados;       // Comandos executados
+    uint32_t lotes;            // Esvaziamentos da fila (um quadro por lote)
+    uint32_t recusados;        // Requisições ou quadros recusados com a fila cheia
+    uint32_t pico_fila;        // Mais comandos à espera ao mesmo tempo
+} comandos_stats_t;
+
+// Contadores do servidor, para ver o quanto se chega perto dos limites do lwipopts.h
+typedef struct {
+    uint32_t aceitas;          // Conexões aceitas
+    uint32_t fechadas;         // Slots devolvidos (conexões fechadas, resetadas ou abortadas)
+    uint32_t descartadas;      // Conexões ociosas fechadas para dar lugar a uma nova
+    uint32_t recusadas;        // Conexões recusadas com a tabela cheia
+    uint32_t esperas;          // Escritas adiadas por falta de espaço no lwIP (conexões encerradas)
+    uint32_t pico_pendente;    // Mais bytes não confirmados numa conexão (limite TCP_SND_BUF)
+    uint16_t pico_fila;        // Maior tcp_sndqueuelen numa conexão (limite TCP_SND_QUEUELEN)
+    uint16_t pico_rx;          // Mais pbufs guardados numa conexão (limite PBUF_POOL_SIZE)
+    uint8_t ativas;            // Slots em uso (limite HTTP_MAX_CONEXOES)
+    uint8_t pico_ativas;
+} servidor_stats_t;
+
+// Estado exibido aos clientes (/state e /events)
+typedef struct {
+    int x, y;
+    int maq1, maq2;
+    bool intruso;
+    uint combustivel;   // 0 - Nenhum; 1 - Tipo 1; 2 - Tipo 2
+} estado_web_t;
+
+// Tabela fixa de conexões: cada slot já traz o parser e os buffers da conexão, então o
+// número de conexões e a memória que elas usam são conhecidos na compilação
+static conexao_t conexoes[HTTP_MAX_CONEXOES];
+static servidor_stats_t servidor_stats;
+
+static conexao_t *sse_clientes[SSE_MAX_CLIENTES];
+static estado_web_t sse_ultimo; // Último estado enviado aos clientes de /events
+
+// Fila de comandos: os callbacks do lwIP enfileiram e o loop principal executa. Os dois lados
+// rodam com o lock do lwIP, então a fila só serve para separar a recepção da lógica do jogo.
+static char comandos[COMANDOS_FILA];
+static spsc_t fila_comandos;
+static comandos_stats_t comandos_stats;
+
+// Função para executar um comando do robô (o mesmo código de uma letra é usado pelo WebSocket)
+static void executa_comando(char comando) {
+    trace_registra(TRACE_COMANDO, (uint8_t)comando);
+    switch (comando) {
+        case 'U': move_robo(0, -1); break;
+        case 'D': move_robo(0, 1); break;
+        case 'L': move_robo(-1, 0); break;
+        case 'R': move_robo(1, 0); break;
+        case 'P': captura_intruso(mundo.robo_x, mundo.robo_y); break;
+        case 'E': entrega_combustivel(mundo.robo_x, mundo.robo_y); break;
+        case 'C': coleta_combustivel(mundo.robo_x, mundo.robo_y); break;
+    }
+}
+
+// Função para saber se o caractere é um comando do robô
+static inline bool comando_valido(char comando) {
+    return comando && strchr("UDLRPEC", comando) != NULL;
+}
+
+// Função para enfileirar uma sequência de comandos, inteira ou nada; retorna false se não houver
+// espaço na fila
+static bool enfileira_comandos(const char *seq, size_t tam) {
+    if (spsc_quantidade(&fila_comandos) + tam > COMANDOS_FILA) {
+        comandos_stats.recusados++;
+        return false;
+    }
+
+    for (size_t i = 0; i < tam; i++) {
+        comandos[spsc_reserva(&fila_comandos)] = seq[i];
+        spsc_publica(&fila_comandos);
+    }
+    uint32_t n = spsc_quantidade(&fila_comandos);
+    if (n > comandos_stats.pico_fila) comandos_stats.pico_fila = n;
+
+    acorda_laco();
+    return true;
+}
+
+// Função para formatar a parte variável da página
+static int formata_informacoes(char *buf, size_t tam) {
+    return snprintf(buf, tam,
     "<div class='info'>"
     "Maquina 1: <strong id='estado-maquina1'>%d/2</strong><br>"
     "Maquina 2: <strong id='estado-maquina2'>%d/2</strong><br>"
     "</div>"
 
     "<div class='info'>"
-    "INTRUSO: <strong id='estado-intruso' class='status'>%s</strong>"
+    "INTRUSO: <strong id='estado-intruso' style='color:%s'>%s</strong>"
     "</div>"
 
-    "<div class='info'>POSIÇÃO: (%d, %d)</div>"
+    "<div class='info'>POSIÇÃO: <span id='posicao'>(%d, %d)</span></div>"
 
     // Nova seção para mostrar o combustível atual
     "<div class='info'>"
-    "COMBUSTÍVEL: <strong>%s</strong>"
-    "</div>"
+    "COMBUSTÍVEL: <strong id='combustivel'>%s</strong>"
+    "</div>",
 
-    "<div style='margin:20px 0'>"
-    "<div><a href='/up'><button class='ctrl'>▲</button></a></div>"
-    "<div>"
-    "<a href='/left'><button class='ctrl'>◀</button></a>"
-    "<a href='/right'><button class='ctrl'>▶</button></a>"
-    "</div>"
-    "<div><a href='/down'><button class='ctrl'>▼</button></a></div>"
-    "</div>"
+    // Argumentos para os placeholders
+    mundo.combustivel_maq1,
+    mundo.combustivel_maq2,
+    mundo.intruso_detectado ? "red" : "green",
+    mundo.intruso_detectado ? "DETECTADO" : "NENHUM",
+    mundo.robo_x, mundo.robo_y,
+    // Novo argumento para status do combustível
+    (mundo.combustivel_robo == 4) ? "Tipo 1" : 
+    (mundo.combustivel_robo == 5) ? "Tipo 2" : "Nenhum"
+    );
+}
 
-    "<div style='margin-top:20px'>"
-    "<a href='/capturar'><button class='btn-vermelho'>Capturar Intruso</button></a>"
-    "</div>"
+// Função para ler o estado atual do jogo
+static void le_estado_web(estado_web_t *e) {
+    e->x = mundo.robo_x;
+    e->y = mundo.robo_y;
+    e->maq1 = mundo.combustivel_maq1;
+    e->maq2 = mundo.combustivel_maq2;
+    e->intruso = mundo.intruso_detectado;
+    e->combustivel = (mundo.combustivel_robo == COMBUSTIVEL_1) ? 1 :
+                     (mundo.combustivel_robo == COMBUSTIVEL_2) ? 2 : 0;
+}
 
-    // Novos botões para combustível
-    "<div style='margin-top:20px'>"
-    "<a href='/entrega'><button class='btn-verde'>Entregar Combustível</button></a>"
-    "<a href='/coleta'><button class='btn-amarelo'>Coletar Combustível</button></a>"
-    "</div>"
+// Função para formatar o estado em JSON; com anterior, apenas os campos que mudaram
+static int formata_estado_json(char *buf, size_t tam, const estado_web_t *e, const estado_web_t *anterior) {
+    int n = snprintf(buf, tam, "{");
+
+    if (!anterior || e->x != anterior->x || e->y != anterior->y)
+        n += snprintf(buf + n, tam - n, "\"x\":%d,\"y\":%d,", e->x, e->y);
+    if (!anterior || e->maq1 != anterior->maq1)
+        n += snprintf(buf + n, tam - n, "\"maq1\":%d,", e->maq1);
+    if (!anterior || e->maq2 != anterior->maq2)
+        n += snprintf(buf + n, tam - n, "\"maq2\":%d,", e->maq2);
+    if (!anterior || e->intruso != anterior->intruso)
+        n += snprintf(buf + n, tam - n, "\"intruso\":%s,", e->intruso ? "true" : "false");
+    if (!anterior || e->combustivel != anterior->combustivel)
+        n += snprintf(buf + n, tam - n, "\"combustivel\":%u,", e->combustivel);
+
+    if (n == 1) return 0;   // Nada mudou
+    buf[n - 1] = '}';       // Troca a última vírgula
+    return n;
+}
 
-    "</body></html>",
+// Função para saber quantos bytes escritos ainda não foram confirmados pelo cliente
+static inline uint32_t pendente(const conexao_t *con) {
+    return con->saida.escrito - con->confirmado;
+}
 
-    // Argumentos para os placeholders
-    intruso_detectado ? "red" : "green",
-    combustivel_maq1,
-    combustivel_maq2,
-    intruso_detectado ? "DETECTADO" : "NENHUM",
-    robo_x, robo_y,
-    // Novo argumento para status do combustível
-    (combustivel_robo == 4) ? "Tipo 1" : 
-    (combustivel_robo == 5) ? "Tipo 2" : "Nenhum"
-);
+// Função para saber se o lwIP já liberou o buffer dinamico (último uso confirmado)
+static inline bool dinamico_livre(const conexao_t *con) {
+    return (int32_t)(con->confirmado - con->dinamico_ate) >= 0;
+}
+
+// Função para enfileirar uma parte da resposta (sem cópia: a parte deve existir até ser
+// confirmada). Com a fila cheia a resposta ficaria incompleta, então a conexão é fechada.
+static void envia(conexao_t *con, const void *dados, uint32_t tam) {
+    if (!saida_adiciona(&con->saida, dados, tam)) con->fechar = true;
+}
+
+// Função para enfileirar um trecho do buffer dinamico e lembrar até onde ele é usado
+static void envia_dinamico(conexao_t *con, uint16_t inicio, uint16_t tam) {
+    uint32_t fim = saida_adiciona(&con->saida, con->dinamico + inicio, tam);
+    if (fim) con->dinamico_ate = fim;
+    else con->fechar = true;
+}
+
+// Função para enviar as mudanças de estado a todos os clientes de /events
+void sse_publica() {
+    estado_web_t atual;
+    char evento[128], completo[128];
+    int n_completo = 0;
+
+    le_estado_web(&atual);
+    memcpy(evento, "data: ", 6);
+    int n = formata_estado_json(evento + 6, sizeof(evento) - 8, &atual, &sse_ultimo);
+    sse_ultimo = atual;
+    if (n > 0) {
+        n += 6;
+        evento[n++] = '\n';
+        evento[n++] = '\n';
+    }
+
+    for (int i = 0; i < SSE_MAX_CLIENTES; i++) {
+        conexao_t *con = sse_clientes[i];
+        if (!con) continue;
+
+        // Quem perdeu um evento recebe o estado completo; os demais, só as mudanças
+        const char *ev = evento;
+        int tam = n;
+        if (con->sse_completo) {
+            if (n_completo == 0) {
+                memcpy(completo, "data: ", 6);
+                n_completo = 6 + formata_estado_json(completo + 6, sizeof(completo) - 8, &atual, NULL);
+                completo[n_completo++] = '\n';
+                completo[n_completo++] = '\n';
+            }
+            ev = completo;
+            tam = n_completo;
+        }
+        if (tam == 0) continue;
+
+        // Eventos são pequenos: são copiados para o lwIP e não dependem do buffer da conexão
+        con->sse_completo = !saida_copia(&con->saida, ev, tam);
+        tcp_output(con->pcb);
+    }
+}
+
+// Função para responder com uma resposta fixa e fechar a conexão em seguida
+static void responde_e_fecha(conexao_t *con, const char *resposta, uint32_t tam) {
+    envia(con, resposta, tam);
+    con->fechar = true;
+}
+
+// Função para registrar a conexão como cliente de /events e enviar o estado completo
+static void sse_inicia(conexao_t *con) {
+    int livre = -1;
+    for (int i = 0; i < SSE_MAX_CLIENTES && livre < 0; i++) {
+        if (!sse_clientes[i]) livre = i;
+    }
+    if (livre < 0) {
+        responde_e_fecha(con, resposta_ocupado, sizeof(resposta_ocupado) - 1);
+        return;
+    }
+
+    // Novos clientes recebem o estado completo; os demais continuam recebendo só as mudanças
+    estado_web_t atual;
+    le_estado_web(&atual);
+    int n = snprintf(con->dinamico, sizeof(con->dinamico), "data: ");
+    n += formata_estado_json(con->dinamico + n, sizeof(con->dinamico) - n - 2, &atual, NULL);
+    n += snprintf(con->dinamico + n, sizeof(con->dinamico) - n, "\n\n");
+
+    sse_clientes[livre] = con;
+    con->sse = livre;
+    envia(con, cabecalho_sse, sizeof(cabecalho_sse) - 1);
+    envia_dinamico(con, 0, n);
+}
+
+// Espaço do corpo JSON no buffer da conexão, depois do espaço reservado para o Content-Length
+#define JSON_CORPO (con->dinamico + HTTP_EXTRA_TAM)
+#define JSON_CORPO_TAM (HTTP_DINAMICO_TAM - HTTP_EXTRA_TAM)
+
+// Função para responder com o corpo JSON já formatado em JSON_CORPO
+static void responde_json(conexao_t *con, int tam_corpo) {
+    if (tam_corpo >= JSON_CORPO_TAM) tam_corpo = JSON_CORPO_TAM - 1;
+    int n = snprintf(con->dinamico, HTTP_EXTRA_TAM, "Content-Length: %d\r\nConnection: %s\r\n\r\n",
+                     tam_corpo, con->fechar ? "close" : "keep-alive");
+
+    envia(con, cabecalho_json, sizeof(cabecalho_json) - 1);
+    envia_dinamico(con, 0, n);
+    envia_dinamico(con, HTTP_EXTRA_TAM, tam_corpo);
+}
+
+// Função para responder /state com o estado completo em JSON
+static void responde_estado(conexao_t *con) {
+    estado_web_t atual;
+
+    le_estado_web(&atual);
+    responde_json(con, formata_estado_json(JSON_CORPO, JSON_CORPO_TAM, &atual, NULL));
+}
+
+// Função para responder /stats com os contadores de conexões e os picos de uso do lwIP, ao
+// lado dos limites correspondentes do lwipopts.h
+static void responde_stats(conexao_t *con) {
+    const servidor_stats_t *s = &servidor_stats;
+
+    // As esperas das conexões abertas ainda não foram somadas ao total
+    uint32_t esperas = s->esperas;
+    for (int i = 0; i < HTTP_MAX_CONEXOES; i++) {
+        if (conexoes[i].usada) esperas += conexoes[i].saida.esperas;
+    }
+
+    int tam = snprintf(JSON_CORPO, JSON_CORPO_TAM,
+        "{\"conexoes\":{\"ativas\":%u,\"pico\":%u,\"max\":%u,"
+        "\"aceitas\":%lu,\"descartadas\":%lu,\"recusadas\":%lu},"
+        "\"lwip\":{\"tcp_pcb\":%u,"
+        "\"fila\":{\"pico\":%u,\"max\":%u},"
+        "\"pendente\":{\"pico\":%lu,\"max\":%u},"
+        "\"rx_pbufs\":{\"pico\":%u,\"max\":%u},"
+        "\"esperas\":%lu},"
+        "\"laco\":{\"acordadas\":%lu,\"prazos\":%lu,\"atraso_medio_us\":%lu,\"atraso_max_us\":%lu},"
+        "\"render\":{\"publicados\":%lu,\"desenhados\":%lu,\"descartados\":%lu,\"fila_cheia\":%lu,\"display\":%lu},"
+        "\"comandos\":{\"executados\":%lu,\"lotes\":%lu,\"recusados\":%lu,\"pico_fila\":%lu,\"max\":%u}}",
+        s->ativas, s->pico_ativas, HTTP_MAX_CONEXOES,
+        (unsigned long)s->aceitas, (unsigned long)s->descartadas, (unsigned long)s->recusadas,
+        MEMP_NUM_TCP_PCB,
+        s->pico_fila, TCP_SND_QUEUELEN,
+        (unsigned long)s->pico_pendente, TCP_SND_BUF,
+        s->pico_rx, PBUF_POOL_SIZE,
+        (unsigned long)esperas,
+        (unsigned long)laco_stats.acordadas, (unsigned long)laco_stats.prazos,
+        (unsigned long)(laco_stats.prazos ? laco_stats.atraso_soma_us / laco_stats.prazos : 0),
+        (unsigned long)laco_stats.atraso_max_us,
+        (unsigned long)render_stats.publicados, (unsigned long)render_stats.desenhados,
+        (unsigned long)render_stats.descartados, (unsigned long)render_stats.fila_cheia,
+        (unsigned long)render_stats.display,
+        (unsigned long)comandos_stats.executados, (unsigned long)comandos_stats.lotes,
+        (unsigned long)comandos_stats.recusados, (unsigned long)comandos_stats.pico_fila, COMANDOS_FILA);
+    responde_json(con, tam);
+}
+
+// Função para responder com a página de controle
+static void responde_pagina(conexao_t *con) {
+    // O bloco de informações fica depois do espaço reservado para o Content-Length
+    int tam = formata_informacoes(con->dinamico + HTTP_EXTRA_TAM, HTTP_DINAMICO_TAM - HTTP_EXTRA_TAM);
+    if (tam >= HTTP_DINAMICO_TAM - HTTP_EXTRA_TAM) tam = HTTP_DINAMICO_TAM - HTTP_EXTRA_TAM - 1;
+
+    // O Content-Length é o que permite manter a conexão aberta depois da resposta
+    int n = snprintf(con->dinamico, HTTP_EXTRA_TAM, "Content-Length: %u\r\nConnection: %s\r\n\r\n",
+                     (unsigned)(sizeof(pagina_inicio) - 1 + tam + sizeof(pagina_fim) - 1),
+                     con->fechar ? "close" : "keep-alive");
+
+    // Partes fixas direto da flash; as partes variáveis no buffer da conexão, também sem cópia
+    envia(con, cabecalho_html, sizeof(cabecalho_html) - 1);
+    envia_dinamico(con, 0, n);
+    envia(con, pagina_inicio, sizeof(pagina_inicio) - 1);
+    envia_dinamico(con, HTTP_EXTRA_TAM, tam);
+    envia(con, pagina_fim, sizeof(pagina_fim) - 1);
+}
+
+// Função para gerar o mapa em texto, uma linha por fileira ('R' marca o robô)
+static size_t gera_mapa(uint32_t *cursor, char *buf, size_t max) {
+    uint32_t linha = mapa.largura + 1;
+    uint32_t total = linha * mapa.altura;
+    size_t n = 0;
+
+    while (n < max && *cursor < total) {
+        int x = *cursor % linha, y = *cursor / linha;
+        if (x == mapa.largura) buf[n++] = '\n';
+        else if (x == mundo.robo_x && y == mundo.robo_y) buf[n++] = 'R';
+        else buf[n++] = '0' + mapa_get(&mapa, x, y);
+        (*cursor)++;
+    }
+    return n;
+}
+
+// Função para responder com um corpo gerado aos poucos, no ritmo das confirmações
+static void responde_gerado(conexao_t *con, const char *cabecalho, uint32_t tam, saida_gerador_t gera) {
+    // O HTTP/1.0 não conhece chunked: o fim do corpo é o fechamento da conexão
+    bool chunked = !con->http.http10;
+    if (!chunked) con->fechar = true;
+
+    envia(con, cabecalho, tam);
+    if (chunked) envia(con, cabecalho_chunked, sizeof(cabecalho_chunked) - 1);
+    if (con->fechar) envia(con, cabecalho_fim_close, sizeof(cabecalho_fim_close) - 1);
+    else envia(con, cabecalho_fim, sizeof(cabecalho_fim) - 1);
+    if (!saida_adiciona_gerador(&con->saida, gera, chunked)) con->fechar = true;
+}
+
+// Função para responder /mapa: o corpo pode ser bem maior que o buffer de envio (um mapa de
+// 256x256 tem 64 KiB)
+static void responde_mapa(conexao_t *con) {
+    responde_gerado(con, cabecalho_mapa, sizeof(cabecalho_mapa) - 1, gera_mapa);
+}
+
+//====================================
+//      /metrics
+//====================================
+
+// Pools do lwIP exibidos em /metrics, com o nome usado no rótulo pool
+static const memp_t pools_lwip[] = { MEMP_TCP_PCB, MEMP_TCP_PCB_LISTEN, MEMP_TCP_SEG, MEMP_PBUF, MEMP_PBUF_POOL };
+static const char *const nomes_pools[] = { "tcp_pcb", "tcp_pcb_listen", "tcp_seg", "pbuf", "pbuf_pool" };
+#define NUM_POOLS (sizeof(pools_lwip) / sizeof(pools_lwip[0]))
+
+static const char *const eventos_link[] = { "enviados", "recebidos", "descartados" };
+
+// Cópia dos contadores formatada por /metrics. Uma resposta inteira sai da mesma cópia, mesmo
+// gerada em vários blocos, e a cópia só é refeita quando nenhuma conexão está no meio de uma.
+typedef struct {
+    metricas_t nucleo0;
+    metricas_nucleo1_t nucleo1;
+    servidor_stats_t servidor;
+    struct stats_mem memp[NUM_POOLS];
+    struct stats_mem mem;
+    struct stats_proto link;
+} instantaneo_t;
+
+static instantaneo_t instantaneo;
+
+// Histogramas de tempo dos subsistemas, uma família (e uma série) cada
+static const struct {
+    const char *nome;
+    const char *ajuda;
+    const histograma_t *h;
+} tempos[] = {
+    { "robovigia_laco_segundos", "Trabalho de uma volta do loop principal, sem a espera",
+      &instantaneo.nucleo0.laco },
+    { "robovigia_atualiza_leds_segundos", "Montagem e publicação de um quadro (atualiza_leds, núcleo 0)",
+      &instantaneo.nucleo0.atualiza_leds },
+    { "robovigia_npwrite_segundos", "Codificação e início do envio à matriz de LEDs (npWrite, núcleo 1)",
+      &instantaneo.nucleo1.npwrite },
+    { "robovigia_display_envio_segundos", "Cópia da janela alterada e início da DMA do display (núcleo 1); a transferência pelo I2C segue sozinha",
+      &instantaneo.nucleo1.display },
+};
+#define NUM_TEMPOS (sizeof(tempos) / sizeof(tempos[0]))
+
+#define NOME_ROTAS "robovigia_http_requisicao_segundos"
+
+// Contadores e medidores: uma família por linha da tabela, com uma série ou uma por rótulo
+enum {
+    FAM_ATIVAS, FAM_ACEITAS, FAM_FECHADAS, FAM_RECUSADAS, FAM_DESCARTADAS,
+    FAM_MEMP_USADOS, FAM_MEMP_PICO, FAM_MEMP_DISPONIVEIS, FAM_MEMP_FALHAS,
+    FAM_MEM_USADOS, FAM_MEM_PICO, FAM_MEM_DISPONIVEIS, FAM_MEM_FALHAS,
+    FAM_LINK,
+    NUM_FAMILIAS
+};
+
+typedef struct {
+    const char *nome;
+    const char *tipo;
+    const char *ajuda;
+    const char *rotulo;            // Rótulo que distingue as séries (NULL: uma série só)
+    const char *const *series;     // Valor do rótulo em cada série
+    uint8_t num_series;
+} familia_t;
+
+static const familia_t familias[NUM_FAMILIAS] = {
+    [FAM_ATIVAS]      = { "robovigia_conexoes_ativas", "gauge", "Conexões HTTP abertas (limite HTTP_MAX_CONEXOES)" },
+    [FAM_ACEITAS]     = { "robovigia_conexoes_aceitas_total", "counter", "Conexões TCP aceitas" },
+    [FAM_FECHADAS]    = { "robovigia_conexoes_fechadas_total", "counter", "Conexões encerradas (fechadas, resetadas ou abortadas)" },
+    [FAM_RECUSADAS]   = { "robovigia_conexoes_recusadas_total", "counter", "Conexões recusadas com 503 por falta de slot" },
+    [FAM_DESCARTADAS] = { "robovigia_conexoes_descartadas_total", "counter", "Conexões keep-alive ociosas fechadas para dar lugar a uma nova" },
+    [FAM_MEMP_USADOS]      = { "robovigia_lwip_memp_usados", "gauge", "Elementos em uso em cada pool do lwIP",
+                               "pool", nomes_pools, NUM_POOLS },
+    [FAM_MEMP_PICO]        = { "robovigia_lwip_memp_pico", "gauge", "Maior uso de cada pool do lwIP desde o boot",
+                               "pool", nomes_pools, NUM_POOLS },
+    [FAM_MEMP_DISPONIVEIS] = { "robovigia_lwip_memp_disponiveis", "gauge", "Tamanho de cada pool do lwIP (lwipopts.h)",
+                               "pool", nomes_pools, NUM_POOLS },
+    [FAM_MEMP_FALHAS]      = { "robovigia_lwip_memp_falhas_total", "counter", "Alocações recusadas por pool cheio",
+                               "pool", nomes_pools, NUM_POOLS },
+    [FAM_MEM_USADOS]      = { "robovigia_lwip_heap_usados_bytes", "gauge", "Bytes em uso no heap do lwIP (escritas com cópia, cabeçalhos)" },
+    [FAM_MEM_PICO]        = { "robovigia_lwip_heap_pico_bytes", "gauge", "Maior uso do heap do lwIP desde o boot" },
+    [FAM_MEM_DISPONIVEIS] = { "robovigia_lwip_heap_disponiveis_bytes", "gauge", "Tamanho do heap do lwIP (MEM_SIZE)" },
+    [FAM_MEM_FALHAS]      = { "robovigia_lwip_heap_falhas_total", "counter", "Alocações recusadas por falta de heap" },
+    [FAM_LINK] = { "robovigia_lwip_link_pacotes_total", "counter", "Pacotes na interface Wi-Fi",
+                   "evento", eventos_link, 3 },
+};
+
+// Função para ler o valor de uma série no instantâneo
+static uint32_t familia_valor(int f, int serie) {
+    const instantaneo_t *m = &instantaneo;
+
+    switch (f) {
+        case FAM_ATIVAS:           return m->servidor.ativas;
+        case FAM_ACEITAS:          return m->servidor.aceitas;
+        case FAM_FECHADAS:         return m->servidor.fechadas;
+        case FAM_RECUSADAS:        return m->servidor.recusadas;
+        case FAM_DESCARTADAS:      return m->servidor.descartadas;
+        case FAM_MEMP_USADOS:      return m->memp[serie].used;
+        case FAM_MEMP_PICO:        return m->memp[serie].max;
+        case FAM_MEMP_DISPONIVEIS: return m->memp[serie].avail;
+        case FAM_MEMP_FALHAS:      return m->memp[serie].err;
+        case FAM_MEM_USADOS:       return m->mem.used;
+        case FAM_MEM_PICO:         return m->mem.max;
+        case FAM_MEM_DISPONIVEIS:  return m->mem.avail;
+        case FAM_MEM_FALHAS:       return m->mem.err;
+        case FAM_LINK:             return serie == 0 ? m->link.xmit : serie == 1 ? m->link.recv : m->link.drop;
+    }
+    return 0;
+}
+
+// Função para copiar os contadores para o instantâneo (com o lock do lwIP). Os do núcleo 1 e os
+// do loop principal são copiados sem lock: no máximo uma amostra aparece pela metade.
+static void metricas_captura(void) {
+    instantaneo.nucleo0 = metricas;
+    instantaneo.nucleo1 = metricas_nucleo1;
+    instantaneo.servidor = servidor_stats;
+    for (size_t i = 0; i < NUM_POOLS; i++) instantaneo.memp[i] = *lwip_stats.memp[pools_lwip[i]];
+    instantaneo.mem = lwip_stats.mem;
+    instantaneo.link = lwip_stats.link;
+}
+
+// Função para escrever a linha k do texto de /metrics; retorna o tamanho (com o '\n'), ou 0
+// depois da última linha
+static int metricas_linha(uint32_t k, char *buf, size_t tam) {
+    // Tempo de cada subsistema
+    for (size_t i = 0; i < NUM_TEMPOS; i++) {
+        if (k < 2) return metricas_cabecalho(buf, tam, tempos[i].nome, "histogram", tempos[i].ajuda, k);
+        k -= 2;
+        if (k < HISTOGRAMA_LINHAS) return histograma_linha(buf, tam, tempos[i].nome, NULL, tempos[i].h, k);
+        k -= HISTOGRAMA_LINHAS;
+    }
+
+    // Latência por rota, só das rotas já pedidas
+    if (k < 2) return metricas_cabecalho(buf, tam, NOME_ROTAS, "histogram", "Da requisição lida à resposta entregue ao lwIP, por rota", k);
+    k -= 2;
+    for (size_t r = 0; r <= NUM_ROTAS; r++) {
+        const histograma_t *h = &instantaneo.nucleo0.rotas[r];
+        if (h->total == 0) continue;
+        if (k < HISTOGRAMA_LINHAS) {
+            char rotulos[40];
+            snprintf(rotulos, sizeof(rotulos), "rota=\"%s\"", r < NUM_ROTAS ? rotas[r].chave + 4 : "desconhecida");
+            return histograma_linha(buf, tam, NOME_ROTAS, rotulos, h, k);
+        }
+        k -= HISTOGRAMA_LINHAS;
+    }
+
+    // Conexões e lwIP
+    for (int f = 0; f < NUM_FAMILIAS; f++) {
+        const familia_t *fam = &familias[f];
+        uint32_t series = fam->rotulo ? fam->num_series : 1;
+
+        if (k < 2) return metricas_cabecalho(buf, tam, fam->nome, fam->tipo, fam->ajuda, k);
+        k -= 2;
+        if (k < series) {
+            unsigned long v = familia_valor(f, k);
+            if (fam->rotulo) return snprintf(buf, tam, "%s{%s=\"%s\"} %lu\n", fam->nome, fam->rotulo, fam->series[k], v);
+            return snprintf(buf, tam, "%s %lu\n", fam->nome, v);
+        }
+        k -= series;
+    }
+    return 0;
+}
+
+// Gerador do corpo de /metrics: o cursor guarda a linha e quanto dela já foi escrito, então um
+// bloco pode terminar no meio de uma linha
+#define METRICAS_CURSOR_BITS 8   // Deslocamento dentro da linha (METRICAS_LINHA_MAX = 256)
+
+static size_t gera_metricas(uint32_t *cursor, char *buf, size_t max) {
+    char linha[METRICAS_LINHA_MAX];
+    size_t n = 0;
+
+    while (n < max) {
+        uint32_t k = *cursor >> METRICAS_CURSOR_BITS;
+        uint32_t feito = *cursor & ((1u << METRICAS_CURSOR_BITS) - 1);
+        int tam = metricas_linha(k, linha, sizeof(linha));
+        if (tam <= 0) break;
+
+        size_t parte = tam - feito;
+        if (parte > max - n) parte = max - n;
+        memcpy(buf + n, linha + feito, parte);
+        n += parte;
+        feito += parte;
+        *cursor = feito == (uint32_t)tam ? (k + 1) << METRICAS_CURSOR_BITS : (k << METRICAS_CURSOR_BITS) | feito;
+    }
+    return n;
+}
+
+// Função para responder /metrics no formato de texto do Prometheus (uns 6 KiB, gerados aos
+// poucos como o /mapa)
+static void responde_metricas(conexao_t *con) {
+    bool em_andamento = false;
+    for (int i = 0; i < HTTP_MAX_CONEXOES; i++) {
+        if (conexoes[i].usada && saida_gerando(&conexoes[i].saida, gera_metricas)) em_andamento = true;
+    }
+    if (!em_andamento) metricas_captura();
+
+    responde_gerado(con, cabecalho_metricas, sizeof(cabecalho_metricas) - 1, gera_metricas);
+}
+
+// Função para tirar a conexão da lista de clientes de /events
+static void sse_remove(conexao_t *con) {
+    if (con->sse >= 0) {
+        sse_clientes[con->sse] = NULL;
+        con->sse = -1;
+    }
+}
+
+// Função para ocupar um slot livre da tabela de conexões; retorna NULL se estiver cheia
+static conexao_t *aloca_conexao(void)
+{
+    for (int i = 0; i < HTTP_MAX_CONEXOES; i++) {
+        conexao_t *con = &conexoes[i];
+        if (con->usada) continue;
+
+        memset(con, 0, sizeof(*con));
+        con->usada = true;
+        if (++servidor_stats.ativas > servidor_stats.pico_ativas) servidor_stats.pico_ativas = servidor_stats.ativas;
+        return con;
+    }
+    return NULL;
+}
+
+// Função para devolver o slot da conexão à tabela
+static void devolve_conexao(conexao_t *con)
+{
+    servidor_stats.esperas += con->saida.esperas;
+    servidor_stats.fechadas++;
+    servidor_stats.ativas--;
+    con->usada = false;
+}
+
+// Função de callback para erros na conexão (o PCB já foi liberado pelo lwIP)
+static void tcp_server_err(void *arg, err_t err)
+{
+    conexao_t *con = (conexao_t *)arg;
+    if (!con) return;
+    sse_remove(con);
+    if (con->rx) pbuf_free(con->rx);
+    devolve_conexao(con);
+}
+
+// Função para desligar os callbacks e liberar o estado da conexão
+static void libera_conexao(struct tcp_pcb *tpcb, conexao_t *con)
+{
+    sse_remove(con);
+    tcp_arg(tpcb, NULL);
+    tcp_err(tpcb, NULL);
+    tcp_sent(tpcb, NULL);
+    tcp_poll(tpcb, NULL, 0);
+    if (con->rx) pbuf_free(con->rx);
+    devolve_conexao(con);
+}
+
+// Função para descartar o que foi recebido e não será mais lido (requisições encadeadas
+// depois de um erro ou de um "Connection: close"), devolvendo a janela com tcp_recved(). Com
+// dados não confirmados, o tcp_close() do lwIP responde com RST e libera o PCB na hora, sem
+// chamar o callback de erro, e a resposta de erro se perde.
+static void descarta_rx(struct tcp_pcb *tpcb, conexao_t *con)
+{
+    uint32_t total = 0;
+
+    if (!con->rx) return;
+    for (struct pbuf *q = con->rx; q; q = q->next) total += q->len;
+    pbuf_free(con->rx);
+    con->rx = NULL;
+
+    while (total > 0) {
+        u16_t n = total > 0xFFFF ? 0xFFFF : total;
+        tcp_recved(tpcb, n);
+        total -= n;
+    }
+}
+
+// Função para fechar a conexão; o lwIP ainda pode estar enviando o buffer da conexão, então
+// o estado só é liberado depois da confirmação. Depois do tcp_close() o PCB só é usado se
+// ainda há confirmações a esperar (com a janela devolvida, ele continua vivo até lá).
+static void fecha_conexao(struct tcp_pcb *tpcb, conexao_t *con)
+{
+    sse_remove(con);
+    descarta_rx(tpcb, con);
+    tcp_recv(tpcb, NULL);
+
+    if (pendente(con) == 0) {
+        libera_conexao(tpcb, con);   // Tira os callbacks antes: o PCB pode não sobreviver ao close
+        if (tcp_close(tpcb) != ERR_OK) tcp_abort(tpcb);
+        return;
+    }
+
+    con->fechada = true;
+    con->ociosa = 0;   // Conta de novo o tempo, agora esperando as confirmações
+    if (tcp_close(tpcb) != ERR_OK) tcp_abort(tpcb);   // Chama tcp_server_err, que libera o slot
+}
+
+// Função para promover a conexão a WebSocket (RFC 6455) respondendo ao handshake
+static void ws_inicia(struct tcp_pcb *tpcb, conexao_t *con)
+{
+    if (con->http.ws_chave_tam == 0) {
+        responde_e_fecha(con, resposta_invalida, sizeof(resposta_invalida) - 1);
+        return;
+    }
+
+    ws_chave_aceite(con->http.ws_chave, con->http.ws_chave_tam, con->dinamico);
+    memcpy(con->dinamico + 28, "\r\n\r\n", 4);
+
+    envia(con, cabecalho_ws, sizeof(cabecalho_ws) - 1);
+    envia_dinamico(con, 0, 32);
+
+    // As respostas são de poucos bytes: sem Nagle, cada uma sai assim que é escrita
+    tcp_nagle_disable(tpcb);
+    con->ws = true;
+}
+
+// Função para enviar um quadro WebSocket pequeno (copiado para o lwIP)
+static void ws_envia(conexao_t *con, ws_opcode_t op, const uint8_t *payload, size_t tam)
+{
+    uint8_t quadro[4 + WS_PAYLOAD_MAX];
+    size_t n = ws_cabecalho(quadro, op, tam);
+
+    memcpy(quadro + n, payload, tam);
+    n += tam;
+    // Sem espaço no lwIP a resposta é descartada; a próxima já traz o estado completo
+    saida_copia(&con->saida, quadro, n);
+}
+
+// Função para responder a um comando com o estado em 6 bytes:
+// comando, x, y, máquina 1, máquina 2, intruso (bit 0) | combustível << 1
+static void ws_confirma(conexao_t *con, uint8_t comando)
+{
+    estado_web_t e;
+    le_estado_web(&e);
+
+    uint8_t ack[6] = { comando, e.x, e.y, e.maq1, e.maq2, e.intruso | e.combustivel << 1 };
+    ws_envia(con, WS_BINARIO, ack, sizeof(ack));
+}
+
+// Função para fechar o WebSocket com um código de status (1000 = normal, 1002 = erro de protocolo)
+static void ws_fecha(conexao_t *con, uint16_t codigo)
+{
+    uint8_t payload[2] = { codigo >> 8, codigo & 0xFF };
+
+    ws_envia(con, WS_FECHAR, payload, sizeof(payload));
+    con->fechar = true;
+}
+
+// Função para processar os quadros WebSocket acumulados na entrada. Cada byte de um quadro de
+// dados é um comando (U, D, L, R, P, E, C); o quadro inteiro vai para a fila de comandos e é
+// respondido com um único ack depois de executado. Os quadros seguintes esperam esse ack.
+static void processa_ws(conexao_t *con)
+{
+    uint8_t *inicio = (uint8_t *)con->entrada;
+    size_t resto = con->entrada_tam;
+    ws_opcode_t op;
+    uint8_t *payload;
+    size_t tam;
+    int usado = 0;
+
+    while (!con->aguarda && (usado = ws_decodifica(inicio, resto, &op, &payload, &tam)) > 0) {
+        inicio += usado;
+        resto -= usado;
+
+        if (op == WS_BINARIO || op == WS_TEXTO) {
+            if (tam == 0) continue;
+            if (enfileira_comandos((const char *)payload, tam)) {
+                con->aguarda = AGUARDA_WS;
+                con->ws_comando = payload[tam - 1];
+            } else {
+                ws_confirma(con, 0);   // Fila cheia: nada executado, ack com o estado atual
+            }
+        } else if (op == WS_PING) {
+            ws_envia(con, WS_PONG, payload, tam);
+        } else if (op == WS_FECHAR) {
+            ws_fecha(con, 1000);
+            return;
+        }
+    }
+
+    // Quadro inválido, ou um quadro que não cabe na entrada e nunca vai se completar
+    if (usado < 0 || (!con->aguarda && resto == sizeof(con->entrada))) {
+        ws_fecha(con, 1002);
+        return;
+    }
+
+    memmove(con->entrada, inicio, resto);
+    con->entrada_tam = resto;
+}
+
+// Função para receber bytes de uma conexão WebSocket; retorna quantos foram copiados para a entrada
+static size_t recebe_ws(conexao_t *con, const char *dados, size_t tam)
+{
+    size_t livre = sizeof(con->entrada) - con->entrada_tam;
+    if (tam > livre) tam = livre;
+
+    memcpy(con->entrada + con->entrada_tam, dados, tam);
+    con->entrada_tam += tam;
+    processa_ws(con);
+    return tam;
+}
+
+// Função para enfileirar a sequência de /cmd?seq=UURRDC; a resposta (o estado em JSON) sai
+// depois que o loop principal executar a sequência inteira, com um único quadro
+static void trata_cmd(conexao_t *con)
+{
+    const char *q = con->http.query;
+    const char *seq = NULL;
+
+    // Com a query cortada, a sequência seria executada só em parte
+    if (con->http.query_cortada) {
+        responde_e_fecha(con, resposta_uri_grande, sizeof(resposta_uri_grande) - 1);
+        return;
+    }
+
+    // Procura o parâmetro seq entre os da query
+    while (*q) {
+        if (strncmp(q, "seq=", 4) == 0) { seq = q + 4; break; }
+        q = strchr(q, '&');
+        if (!q) break;
+        q++;
+    }
+    if (!seq) {
+        responde_e_fecha(con, resposta_invalida, sizeof(resposta_invalida) - 1);
+        return;
+    }
+
+    size_t tam = strcspn(seq, "&");
+    for (size_t i = 0; i < tam; i++) {
+        if (!comando_valido(seq[i])) {
+            responde_e_fecha(con, resposta_invalida, sizeof(resposta_invalida) - 1);
+            return;
+        }
+    }
+
+    if (tam == 0) responde_estado(con);
+    else if (enfileira_comandos(seq, tam)) con->aguarda = AGUARDA_ESTADO;
+    else responde_e_fecha(con, resposta_ocupado, sizeof(resposta_ocupado) - 1);
+}
+
+// Função para atender a requisição que o parser acabou de reconhecer
+static void trata_requisicao(struct tcp_pcb *tpcb, conexao_t *con)
+{
+    int id = con->http.rota >= 0 ? rotas[con->http.rota].id : 0;
+
+    printf("Request: %s\n", con->http.rota >= 0 ? rotas[con->http.rota].chave : "(rota desconhecida)");
+    con->fechar = http_fecha_apos(&con->http);
+
+    switch (id) {
+    case 0:
+        envia(con, resposta_nao_encontrada, sizeof(resposta_nao_encontrada) - 1);
+        break;
+    case ROTA_ESTADO:   // Endpoints de estado e o WebSocket não executam comandos nem enviam a página
+        responde_estado(con);
+        break;
+    case ROTA_EVENTOS:
+        sse_inicia(con);
+        break;
+    case ROTA_MAPA:
+        responde_mapa(con);
+        break;
+    case ROTA_STATS:
+        responde_stats(con);
+        break;
+    case ROTA_METRICAS:
+        responde_metricas(con);
+        break;
+    case ROTA_WS:
+        ws_inicia(tpcb, con);
+        break;
+    case ROTA_CMD:
+        trata_cmd(con);
+        break;
+    default:
+    {
+        // Comando do robô: a página com o novo estado sai depois que o loop principal o executar
+        char comando = id;
+        if (enfileira_comandos(&comando, 1)) con->aguarda = AGUARDA_PAGINA;
+        else responde_e_fecha(con, resposta_ocupado, sizeof(resposta_ocupado) - 1);
+        break;
+    }
+    }
+}
+
+// Argumento dos eventos de requisição no trace: rota medida e índice da conexão
+static inline uint16_t trace_conexao(const conexao_t *con)
+{
+    return (uint8_t)con->medida << 8 | (uint16_t)(con - conexoes);
+}
+
+// Função para passar bytes ao parser HTTP e atender a requisição se ela terminar; retorna
+// quantos bytes foram consumidos
+static size_t recebe_http(struct tcp_pcb *tpcb, conexao_t *con, const char *dados, size_t tam)
+{
+    size_t usados;
+    http_resultado_t r = http_parser_alimenta(&con->http, dados, tam, &usados);
+
+    if (r == HTTP_INCOMPLETA) return usados;   // Espera o resto
+
+    con->medida = (r == HTTP_COMPLETA && con->http.rota >= 0) ? con->http.rota : (int8_t)NUM_ROTAS;
+    con->medida_inicio_us = time_us_32();
+    trace_registra(TRACE_REQUISICAO, trace_conexao(con));
+    if (r == HTTP_COMPLETA) trata_requisicao(tpcb, con);
+    else if (r == HTTP_GRANDE) responde_e_fecha(con, resposta_grande, sizeof(resposta_grande) - 1);
+    else responde_e_fecha(con, resposta_invalida, sizeof(resposta_invalida) - 1);
+    http_parser_reinicia(&con->http);
+    return usados;
+}
+
+// Função para registrar a latência da requisição em andamento, assim que a resposta inteira foi
+// entregue ao lwIP
+static void mede_requisicao(conexao_t *con)
+{
+    if (con->medida < 0 || con->aguarda || !saida_vazia(&con->saida)) return;
+    histograma_registra(&metricas.rotas[con->medida], time_us_32() - con->medida_inicio_us);
+    trace_registra(TRACE_RESPOSTA, trace_conexao(con));
+    con->medida = -1;
+}
 
+// Função para processar os dados recebidos guardados em con->rx, lendo cada pbuf no lugar.
+// Uma nova requisição só é lida depois que a resposta anterior foi toda entregue ao lwIP e o
+// buffer dinamico foi confirmado; até lá os dados ficam guardados e a janela TCP não é
+// reaberta, o que segura o cliente. Requisições encadeadas são respondidas em ordem.
+static void processa_rx(struct tcp_pcb *tpcb, conexao_t *con)
+{
+    u16_t consumido = 0;
+
+    while (con->rx && !con->fechar) {
+        const char *dados = (const char *)con->rx->payload;
+        size_t tam = con->rx->len, usados = tam;
+
+        if (con->ws) {
+            usados = recebe_ws(con, dados, tam);
+            if (usados == 0) break;   // Entrada cheia à espera de um ack
+        } else if (con->sse < 0) {
+            if (con->aguarda || !saida_vazia(&con->saida) || !dinamico_livre(con)) break;
+            usados = recebe_http(tpcb, con, dados, tam);
+            if (!saida_bombeia(&con->saida)) con->fechar = true;
+            mede_requisicao(con);
+        }
+        // Clientes de /events não enviam mais nada de útil: o resto é descartado
+
+        con->rx = pbuf_free_header(con->rx, usados);
+        consumido += usados;
+    }
 
-    tcp_write(tpcb, html, strlen(html), TCP_WRITE_FLAG_COPY);
+    if (consumido) tcp_recved(tpcb, consumido);
+}
+
+// Função para fazer a conexão andar: entrega ao lwIP o que couber da resposta, lê as próximas
+// requisições quando possível e fecha a conexão quando combinado. Chamada ao receber dados,
+// a cada confirmação e periodicamente. Retorna false se a conexão foi fechada.
+static bool atende(struct tcp_pcb *tpcb, conexao_t *con)
+{
+    if (!saida_bombeia(&con->saida)) {
+        saida_descarta(&con->saida);
+        con->fechar = true;
+    }
+    mede_requisicao(con);
+    processa_rx(tpcb, con);
+
+    uint32_t p = pendente(con);
+    if (p > servidor_stats.pico_pendente) servidor_stats.pico_pendente = p;
+    if (tcp_sndqueuelen(tpcb) > servidor_stats.pico_fila) servidor_stats.pico_fila = tcp_sndqueuelen(tpcb);
+
+    // Só fecha depois que toda a resposta foi entregue ao lwIP
+    bool encerrar = con->fechar || (con->fim_recebido && !con->rx);
+    if (encerrar && !con->aguarda && saida_vazia(&con->saida)) {
+        fecha_conexao(tpcb, con);
+        return false;
+    }
     tcp_output(tpcb);
-    pbuf_free(p);
+    return true;
+}
+
+// Função para executar os comandos enfileirados (no loop principal, com o lock do lwIP). Os
+// movimentos do lote inteiro são executados um a um, mas viram um só quadro e um só evento;
+// depois as conexões que esperavam pelo lote recebem as suas respostas.
+static void executa_comandos(void)
+{
+    uint32_t executados = 0;
+    int i;
+
+    while ((i = spsc_proximo(&fila_comandos)) >= 0) {
+        executa_comando(comandos[i]);
+        spsc_consome(&fila_comandos);
+        executados++;
+    }
+    if (!executados) return;
+
+    comandos_stats.executados += executados;
+    comandos_stats.lotes++;
+    if (mundo_pendente()) atualiza_leds();
+
+    for (int c = 0; c < HTTP_MAX_CONEXOES; c++) {
+        conexao_t *con = &conexoes[c];
+        if (!con->usada || con->fechada || !con->aguarda) continue;
+
+        uint8_t aguarda = con->aguarda;
+        con->aguarda = AGUARDA_NADA;
+        if (aguarda == AGUARDA_PAGINA) {
+            responde_pagina(con);
+        } else if (aguarda == AGUARDA_ESTADO) {
+            responde_estado(con);
+        } else {
+            ws_confirma(con, con->ws_comando);
+            processa_ws(con);   // Quadros que chegaram enquanto este esperava
+        }
+        atende(con->pcb, con);  // Envia a resposta e lê as próximas requisições
+    }
+}
+
+// Função de callback chamada quando o cliente confirma dados enviados
+static err_t tcp_server_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
+{
+    conexao_t *con = (conexao_t *)arg;
+
+    con->confirmado += len;
+    con->ociosa = 0;
+    if (con->fechada) {
+        if (pendente(con) == 0) libera_conexao(tpcb, con);
+        return ERR_OK;
+    }
+
+    // Espaço liberado no buffer de envio: continua a resposta em andamento
+    atende(tpcb, con);
+    return ERR_OK;
+}
+
+// Função de callback periódica (tcp_poll): retoma escritas que pararam por falta de memória no
+// lwIP e fecha conexões keep-alive sem atividade. Clientes de /events e WebSockets ficam
+// abertos, já que o servidor é quem envia quando há novidades. Uma conexão já fechada que
+// passa o mesmo tempo sem confirmar o resto da resposta é abortada, devolvendo o slot.
+static err_t tcp_server_poll(void *arg, struct tcp_pcb *tpcb)
+{
+    conexao_t *con = (conexao_t *)arg;
+
+    if (!con) return ERR_OK;
+    if (con->fechada) {
+        if (++con->ociosa < HTTP_OCIOSA_MAX) return ERR_OK;
+        tcp_abort(tpcb);   // Chama tcp_server_err, que libera o slot
+        return ERR_ABRT;
+    }
+    if (!atende(tpcb, con)) return ERR_OK;
+    if (con->sse >= 0 || con->ws) return ERR_OK;
+    if (++con->ociosa >= HTTP_OCIOSA_MAX) fecha_conexao(tpcb, con);
     return ERR_OK;
 }
 
-// Função de callback ao aceitar conexões TCP
+// Função de callback para processar requisições HTTP
+static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+    conexao_t *con = (conexao_t *)arg;
+
+    if (!p){
+        // O cliente não envia mais nada, mas ainda recebe o que falta das respostas
+        con->fim_recebido = true;
+        atende(tpcb, con);
+        return ERR_OK;
+    }
+
+    // Uma requisição pode chegar partida em vários segmentos, e um segmento pode trazer várias
+    // requisições: os pbufs ficam encadeados na conexão até serem processados
+    if (con->rx) pbuf_cat(con->rx, p);
+    else con->rx = p;
+
+    u16_t guardados = pbuf_clen(con->rx);
+    if (guardados > servidor_stats.pico_rx) servidor_stats.pico_rx = guardados;
+
+    con->ociosa = 0;
+    atende(tpcb, con);
+    return ERR_OK;
+}
+
+// Função para fechar a conexão keep-alive ociosa há mais tempo, abrindo um slot na tabela.
+// Só servem conexões entre requisições (nada a receber, nada a enviar e nada por confirmar)
+// e sem atividade há HTTP_DESCARTE_MIN chamadas de tcp_poll: um cliente que acabou de ser
+// atendido vai mandar a próxima requisição, e fechá-lo faria os clientes se derrubarem uns aos
+// outros com a tabela cheia. Sem nenhuma assim, a nova conexão recebe o 503.
+static bool descarta_ociosa(void)
+{
+    conexao_t *escolhida = NULL;
+
+    for (int i = 0; i < HTTP_MAX_CONEXOES; i++) {
+        conexao_t *con = &conexoes[i];
+        if (!con->usada || con->fechada || con->sse >= 0 || con->ws || con->aguarda) continue;
+        if (con->rx || con->http.lidos > 0 || !saida_vazia(&con->saida) || pendente(con) > 0) continue;
+        if (con->ociosa < HTTP_DESCARTE_MIN) continue;
+        if (!escolhida || con->ociosa > escolhida->ociosa) escolhida = con;
+    }
+    if (!escolhida) return false;
+
+    servidor_stats.descartadas++;
+    fecha_conexao(escolhida->pcb, escolhida);
+    return true;
+}
+
+// Função de callback periódica das conexões recusadas: o cliente já teve tempo de ler o 503
+static err_t tcp_recusada_poll(void *arg, struct tcp_pcb *tpcb)
+{
+    tcp_abort(tpcb);
+    return ERR_ABRT;
+}
+
+// Função para recusar uma conexão com a tabela cheia. O 503 sai direto da flash e o PCB fica
+// sem estado: o lwIP descarta o que o cliente enviar e o PCB é abortado no próximo tcp_poll.
+static err_t recusa_conexao(struct tcp_pcb *newpcb)
+{
+    servidor_stats.recusadas++;
+    if (tcp_write(newpcb, resposta_ocupado, sizeof(resposta_ocupado) - 1, 0) != ERR_OK ||
+        tcp_shutdown(newpcb, 0, 1) != ERR_OK) {
+        tcp_abort(newpcb);
+        return ERR_ABRT;
+    }
+
+    // Primeiro PCB a ser reaproveitado se o lwIP ficar sem PCBs livres
+    tcp_setprio(newpcb, TCP_PRIO_MIN);
+    tcp_poll(newpcb, tcp_recusada_poll, HTTP_POLL_INTERVALO);
+    return ERR_OK;
+}
+
+// Função de callback ao aceitar conexões TCP. Com a tabela cheia, uma conexão keep-alive
+// ociosa dá lugar à nova; se não houver nenhuma, a nova é recusada.
 static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
 {
+    if (err != ERR_OK || !newpcb) return ERR_VAL;
+
+    conexao_t *con = aloca_conexao();
+    if (!con && descarta_ociosa()) con = aloca_conexao();
+    if (!con) return recusa_conexao(newpcb);
+
+    servidor_stats.aceitas++;
+    con->sse = -1;
+    con->medida = -1;
+    con->pcb = newpcb;
+    saida_init(&con->saida, newpcb);
+    http_parser_init(&con->http, rotas, NUM_ROTAS);
+    tcp_arg(newpcb, con);
+    tcp_err(newpcb, tcp_server_err);
+    tcp_sent(newpcb, tcp_server_sent);
     tcp_recv(newpcb, tcp_server_recv);
+    tcp_poll(newpcb, tcp_server_poll, HTTP_POLL_INTERVALO);
     return ERR_OK;
 }
 
@@ -610,6 +2027,76 @@ int server_init(void) {
     return 1;
 }
 
+//====================================
+//      Trace pela USB
+//====================================
+
+// Com o trace ligado ('T' pelo console; 't' desliga), o loop principal envia os eventos pela
+// USB (CDC) em blocos binários, misturados ao texto do printf; tools/trace2chrome.py separa os
+// blocos e gera um trace do Chrome. Os eventos são gravados sempre: ligar só começa a drenagem.
+#define TRACE_DRENA_MS 20   // Intervalo das drenagens com o trace ligado
+
+// Identificação dos temporizadores nos eventos TRACE_ALARME
+enum {
+    ALARME_OUTRO,           // Temporizadores das bibliotecas (ex.: beeps do buzzer)
+    ALARME_LED,
+    ALARME_CONSUMO,
+    ALARME_RECARGA_1,
+    ALARME_RECARGA_2,
+    ALARME_TRACE,
+};
+
+static bool trace_ligado = false;
+static temporizador_t trace_temporizador;   // Acorda o loop para drenar
+
+// Função de callback do temporizador do trace: só acorda o loop, que drena fora do lock do lwIP
+static void trace_acorda(temporizador_t *t) {
+}
+
+// Função para registrar os disparos da roda de temporizadores no trace
+static void trace_temporizadores(const temporizador_t *t, bool fim) {
+    uint16_t id = t == &led_temporizador ? ALARME_LED :
+                  t == &consumo_temporizador ? ALARME_CONSUMO :
+                  t == &recarga_1_temporizador ? ALARME_RECARGA_1 :
+                  t == &recarga_2_temporizador ? ALARME_RECARGA_2 :
+                  t == &trace_temporizador ? ALARME_TRACE : ALARME_OUTRO;
+    trace_registra(fim ? TRACE_ALARME_FIM : TRACE_ALARME, id);
+}
+
+// Função para ler os comandos do trace no console, sem esperar (no loop principal)
+static void trace_console(void) {
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c == 'T' && !trace_ligado) {
+            trace_ligado = true;
+            cyw43_arch_lwip_begin();   // A roda é compartilhada com os callbacks do lwIP
+            temporizador_agenda(&trace_temporizador, TRACE_DRENA_MS, TRACE_DRENA_MS);
+            cyw43_arch_lwip_end();
+        } else if (c == 't' && trace_ligado) {
+            trace_ligado = false;
+            cyw43_arch_lwip_begin();
+            temporizador_cancela(&trace_temporizador);
+            cyw43_arch_lwip_end();
+        }
+    }
+}
+
+// Função para enviar pela USB os eventos gravados desde a última drenagem; cada bloco vai numa
+// só escrita, sem ser cortado pelo texto do printf
+static void trace_envia(void) {
+    static uint8_t bloco[TRACE_BLOCO_MAX];
+    static unsigned nucleo = 0;
+
+    if (!trace_ligado || !stdio_usb_connected()) return;
+
+    // Um bloco de cada núcleo por vez: o que chegar durante o envio fica para a próxima
+    for (int i = 0; i < 2; i++) {
+        size_t tam = trace_drena(bloco, &nucleo);
+        if (!tam) break;
+        stdio_usb.out_chars((const char *)bloco, tam);
+    }
+}
+
 //====================================
 //      Funções de Harwdware       
 //====================================
@@ -618,6 +2105,8 @@ int server_init(void) {
 static void gpio_button_handler(uint gpio, uint32_t events) {
     uint32_t current_time = to_us_since_boot(get_absolute_time());
 
+    trace_registra(TRACE_BOTAO, gpio);
+
     if (gpio == BUTTON_A) {
         if (current_time - last_time_button_a > 200000) {
             last_time_button_a = current_time;
@@ -631,6 +2120,10 @@ static void gpio_button_handler(uint gpio, uint32_t events) {
     } else if (gpio == BUTTON_JOYSTICK) {
         printf("\nHABILITANDO O MODO GRAVAÇÃO\n");
 
+        // O display é do núcleo 1: para o núcleo e espera o último envio terminar
+        multicore_reset_core1();
+        while (ssd1306_flush_busy(&ssd)) tight_loop_contents();
+
         ssd1306_fill(&ssd, false);
         ssd1306_draw_string(&ssd, "  HABILITANDO", 5, 25);
         ssd1306_draw_string(&ssd, " MODO GRAVACAO", 5, 38);
@@ -643,6 +2136,26 @@ static void gpio_button_handler(uint gpio, uint32_t events) {
 //Configuração inicial de hardware
 int setup() {
     stdio_init_all();
+    trace_init();   // Antes dos drivers, que também registram eventos
+
+    // Roda de temporizadores (LED, buzzer, respawn e consumo de combustível)
+    temporizador_roda_init(relogio_ms);
+    temporizador_init(&led_temporizador, led_alterna, NULL);
+    temporizador_init(&consumo_temporizador, consome_combustivel, NULL);
+    temporizador_init(&recarga_1_temporizador, recarrega_combustivel_1, NULL);
+    temporizador_init(&recarga_2_temporizador, recarrega_combustivel_2, NULL);
+    temporizador_init(&trace_temporizador, trace_acorda, NULL);
+    temporizador_ao_disparar(trace_temporizadores);
+
+    // Carrega o mapa da fábrica
+    if (!mapa_carrega(&mapa, mapa_inicial, MAPA_LARGURA, MAPA_ALTURA)) {
+        printf("Falha ao alocar o mapa\n");
+        return -1;
+    }
+    if (!visibilidade_init()) {
+        printf("Falha ao alocar o campo de visao\n");
+        return -1;
+    }
 
     adc_init();
     adc_gpio_init(VRY_PIN);  // Eixo Y
@@ -684,17 +2197,72 @@ int setup() {
     gpio_set_irq_enabled_with_callback(BUTTON_B, GPIO_IRQ_EDGE_FALL, true, &gpio_button_handler);
     gpio_set_irq_enabled_with_callback(BUTTON_JOYSTICK, GPIO_IRQ_EDGE_FALL, true, &gpio_button_handler);
 
+    // Fila de quadros e núcleo 1 (matriz de LEDs e display) antes do servidor, que já pode
+    // montar quadros ao receber comandos. A partir daqui o display é do núcleo 1.
+    spsc_init(&fila_quadros, QUADROS_FILA);
+    multicore_launch_core1(core1_main);
+    spsc_init(&fila_comandos, COMANDOS_FILA);
+
     //Inicia o servidor
     int resposta = server_init();
 
-    ssd1306_fill(&ssd, false);
-    if(resposta == -1) ssd1306_draw_string(&ssd, "Erro na Conexao", 0, 28);
-    else               ssd1306_draw_string(&ssd, " Servidor Ativo ", 0, 28);
-    ssd1306_send_data(&ssd);
+    // Com o servidor ativo, o painel de estado é desenhado pelo núcleo 1 no primeiro quadro;
+    // com erro não haverá quadros, e o núcleo 1 fica parado na FIFO
+    if(resposta == -1) {
+        ssd1306_fill(&ssd, false);
+        ssd1306_draw_string(&ssd, "Erro na Conexao", 0, 28);
+        ssd1306_send_data(&ssd);
+    }
 
     return resposta;
 }
 
+//====================================
+//      Loop Principal
+//====================================
+
+// Trabalho sem conteúdo: serve apenas para acordar o loop principal, que espera em
+// cyw43_arch_wait_for_work_until() pelo mesmo contexto assíncrono do Wi-Fi
+static void laco_acordado(async_context_t *context, async_when_pending_worker_t *worker) {
+}
+
+static async_when_pending_worker_t trabalho_laco = { .do_work = laco_acordado };
+
+// Função para acordar o loop principal depois de mudar algo que ele deve atender
+void acorda_laco(void) {
+    async_context_set_work_pending(cyw43_arch_async_context(), &trabalho_laco);
+}
+
+// Função para calcular até quando o loop pode dormir (µs desde o boot, 64 bits: não dá a volta
+// como os ms de 32 bits da roda); *tem_prazo indica se é o prazo de um temporizador (e não só a
+// salvaguarda)
+static uint64_t laco_prazo(bool *tem_prazo) {
+    // Lido antes da roda: se o ms virar entre os dois, o prazo sai adiantado, nunca atrasado
+    uint64_t agora = to_us_since_boot(get_absolute_time());
+    uint64_t prazo = agora + LACO_ESPERA_MAX_MS * 1000ull;
+    uint32_t espera;
+
+    *tem_prazo = false;
+    if (temporizador_proximo(&espera) && espera < LACO_ESPERA_MAX_MS) {
+        prazo = (agora / 1000 + espera) * 1000;   // Início do ms em que a roda tem trabalho
+        *tem_prazo = true;
+    }
+    return prazo;
+}
+
+// Função para registrar um despertar do loop e, se foi por um prazo, o atraso em relação a ele
+static void laco_mede(bool tem_prazo, uint64_t prazo_us) {
+    uint64_t agora = to_us_since_boot(get_absolute_time());
+
+    laco_stats.acordadas++;
+    if (!tem_prazo || agora < prazo_us) return;   // Acordou antes, por outro motivo
+
+    uint32_t atraso = agora - prazo_us;
+    laco_stats.prazos++;
+    laco_stats.atraso_soma_us += atraso;
+    if (atraso > laco_stats.atraso_max_us) laco_stats.atraso_max_us = atraso;
+}
+
 int main()
 {
     int resposta = setup();
@@ -703,18 +2271,42 @@ int main()
     
     atualiza_leds();
 
-    struct repeating_timer timer;
+    // Temporizadores agendados pelos callbacks do lwIP (comandos pela rede) acordam o loop
+    // pelo contexto assíncrono do Wi-Fi, caso ele esteja dormindo até um prazo mais distante
+    async_context_add_when_pending_worker(cyw43_arch_async_context(), &trabalho_laco);
+
+    // O servidor já está no ar: a partir daqui a roda só é usada com o lock do lwIP
+    cyw43_arch_lwip_begin();
+    temporizador_ao_antecipar(acorda_laco);
 
     // Configura para chamar a função de consumir combustivel a cada 9 segundos
-    add_repeating_timer_ms(9000, consome_combustivel, NULL, &timer);
+    temporizador_agenda(&consumo_temporizador, 9000, 9000);
+    cyw43_arch_lwip_end();
 
     while (true) {
-        if(atualiza_leds_flag) atualiza_leds();
-        
-        buzzer_update();
-        led_update();
+        uint32_t inicio = time_us_32();
+
+        // Os temporizadores e os callbacks do lwIP mexem no mesmo estado do jogo (e na roda):
+        // o lock do lwIP os serializa
+        cyw43_arch_lwip_begin();
+        temporizador_processa();
+        executa_comandos();                       // Comandos recebidos pela rede, um quadro por lote
+        if(mundo_pendente()) atualiza_leds();   // atualiza_leds() também envia eventos pelo lwIP
+
+        // Dorme até o próximo temporizador ou até chegar trabalho (pacotes do Wi-Fi), em vez
+        // de acordar a cada 200 ms sem nada a fazer
+        bool tem_prazo;
+        uint64_t prazo = laco_prazo(&tem_prazo);   // Consulta a roda, ainda com o lock
+        cyw43_arch_lwip_end();
+
         cyw43_arch_poll(); // Necessário para manter o Wi-Fi ativo
-        sleep_ms(200);    
+        trace_console();
+        trace_envia();
+        histograma_registra(&metricas.laco, time_us_32() - inicio);
+        trace_registra(TRACE_ESPERA_INICIO, 0);
+        cyw43_arch_wait_for_work_until(from_us_since_boot(prazo));
+        trace_registra(TRACE_ESPERA_FIM, 0);
+        laco_mede(tem_prazo, prazo);
     }
 
     cyw43_arch_deinit(); // Desativa o CYW43
@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""Converte o trace binário do firmware (lib/trace) para o formato JSON do trace do Chrome.
+
+    python3 tools/trace2chrome.py captura.bin -o trace.json
+    python3 tools/trace2chrome.py --porta /dev/ttyACM0 --segundos 10 -o trace.json
+
+A entrada é o que a placa envia pela USB com o trace ligado: blocos binários misturados ao
+texto do printf, que é ignorado. Com --porta, a captura é feita aqui: envia 'T' para ligar o
+trace, lê pelo tempo pedido e envia 't' para desligar (--bruto guarda os bytes lidos). O JSON
+abre em chrome://tracing ou em https://ui.perfetto.dev.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import time
+
+MAGICO = b"RVTR"
+VERSAO = 1
+CABECALHO = struct.Struct("<4sBBHI")
+EVENTO = struct.Struct("<IHBx")
+EVENTOS_MAX = 4096   # Maior bloco aceito; acima disso é texto que por acaso tem o mágico
+
+(REQUISICAO, RESPOSTA, COMANDO, RENDER_INICIO, RENDER_FIM, FLUSH_INICIO, FLUSH_FIM,
+ ALARME, ALARME_FIM, BOTAO, ESPERA_INICIO, ESPERA_FIM) = range(1, 13)
+
+# Mesma ordem de rotas[] em main.c; a posição seguinte é a rota desconhecida
+ROTAS = ["/", "/capturar", "/cmd", "/coleta", "/down", "/entrega", "/events", "/left", "/mapa",
+         "/metrics", "/right", "/state", "/stats", "/up", "/ws"]
+ALARMES = ["outro", "led", "consumo", "recarga_1", "recarga_2", "trace"]
+SAIDAS = ["matriz de LEDs", "display"]
+
+# Linhas do trace: uma por núcleo e uma por saída (o início e o fim de um envio podem ser
+# gravados em núcleos diferentes)
+LINHA_SAIDA = 10
+NOMES_LINHAS = {0: "núcleo 0", 1: "núcleo 1", LINHA_SAIDA: "matriz de LEDs", LINHA_SAIDA + 1: "display"}
+
+
+def le_blocos(dados):
+    """Retorna [(núcleo, descartados, [(us, arg, tipo)])] de cada bloco encontrado em dados."""
+    blocos = []
+    i = dados.find(MAGICO)
+    while i >= 0:
+        fim = i + CABECALHO.size
+        if fim <= len(dados):
+            _, versao, nucleo, n, descartados = CABECALHO.unpack_from(dados, i)
+            if versao == VERSAO and nucleo < 2 and 0 < n <= EVENTOS_MAX and fim + n * EVENTO.size <= len(dados):
+                eventos = [EVENTO.unpack_from(dados, fim + k * EVENTO.size) for k in range(n)]
+                blocos.append((nucleo, descartados, eventos))
+                i = dados.find(MAGICO, fim + n * EVENTO.size)
+                continue
+        i = dados.find(MAGICO, i + 1)
+    return blocos
+
+
+def desdobra(blocos):
+    """Junta os eventos dos blocos em [(us, núcleo, tipo, arg)], com o tempo em µs de 64 bits
+    (o timer de 32 bits dá a volta a cada ~71 min) e em ordem de tempo."""
+    ultimo = {}
+    voltas = {}
+    eventos = []
+    for nucleo, _, lista in blocos:
+        for us, arg, tipo in lista:
+            # Eventos do mesmo núcleo saem quase em ordem: um recuo de mais de meia volta é a volta
+            if nucleo in ultimo and us < ultimo[nucleo] and ultimo[nucleo] - us > 1 << 31:
+                voltas[nucleo] = voltas.get(nucleo, 0) + 1
+            ultimo[nucleo] = us
+            eventos.append((us + (voltas.get(nucleo, 0) << 32), nucleo, tipo, arg))
+    eventos.sort(key=lambda e: e[0])
+    return eventos
+
+
+def nome_rota(arg):
+    rota = arg >> 8
+    return ROTAS[rota] if rota < len(ROTAS) else "desconhecida"
+
+
+def converte(eventos):
+    saida = [{"ph": "M", "pid": 0, "tid": tid, "name": "thread_name", "args": {"name": nome}}
+             for tid, nome in NOMES_LINHAS.items()]
+    saida.append({"ph": "M", "pid": 0, "name": "process_name", "args": {"name": "RoboVigia"}})
+    if not eventos:
+        return saida
+
+    inicio = eventos[0][0]
+    abertos = {}   # (linha, nome) -> quantos "B" sem "E"
+
+    def duracao(fase, tid, nome, ts, args=None):
+        chave = (tid, nome)
+        if fase == "E":
+            if not abertos.get(chave):
+                return   # O início ficou antes da captura
+            abertos[chave] -= 1
+        else:
+            abertos[chave] = abertos.get(chave, 0) + 1
+        e = {"ph": fase, "pid": 0, "tid": tid, "name": nome, "ts": ts}
+        if args:
+            e["args"] = args
+        saida.append(e)
+
+    def instante(tid, nome, ts, args):
+        saida.append({"ph": "i", "s": "t", "pid": 0, "tid": tid, "name": nome, "ts": ts, "args": args})
+
+    for us, nucleo, tipo, arg in eventos:
+        ts = us - inicio
+        if tipo in (REQUISICAO, RESPOSTA):
+            # Requisições de conexões diferentes se sobrepõem: eventos assíncronos, um por conexão
+            saida.append({"ph": "b" if tipo == REQUISICAO else "e", "cat": "http", "pid": 0, "tid": nucleo,
+                          "id": arg & 0xFF, "name": "GET " + nome_rota(arg), "ts": ts,
+                          "args": {"conexao": arg & 0xFF}})
+        elif tipo == COMANDO:
+            instante(nucleo, "comando " + chr(arg & 0xFF), ts, {"comando": chr(arg & 0xFF)})
+        elif tipo in (RENDER_INICIO, RENDER_FIM):
+            duracao("B" if tipo == RENDER_INICIO else "E", nucleo, "render", ts)
+        elif tipo in (FLUSH_INICIO, FLUSH_FIM):
+            nome = "envio " + (SAIDAS[arg] if arg < len(SAIDAS) else str(arg))
+            # Os envios de uma saída não se sobrepõem: um início com o anterior aberto o encerra
+            # (duas transferências podem ser atendidas por uma só interrupção)
+            if tipo == FLUSH_INICIO and abertos.get((LINHA_SAIDA + arg, nome)):
+                duracao("E", LINHA_SAIDA + arg, nome, ts)
+            duracao("B" if tipo == FLUSH_INICIO else "E", LINHA_SAIDA + arg, nome, ts)
+        elif tipo in (ALARME, ALARME_FIM):
+            nome = "alarme " + (ALARMES[arg] if arg < len(ALARMES) else str(arg))
+            duracao("B" if tipo == ALARME else "E", nucleo, nome, ts)
+        elif tipo == BOTAO:
+            instante(nucleo, "botão", ts, {"gpio": arg})
+        elif tipo in (ESPERA_INICIO, ESPERA_FIM):
+            duracao("B" if tipo == ESPERA_INICIO else "E", nucleo, "espera", ts)
+        else:
+            instante(nucleo, f"tipo {tipo}", ts, {"arg": arg})
+    return saida
+
+
+def captura(porta, segundos):
+    """Lê da porta serial da placa (USB CDC) com o trace ligado pelo tempo pedido."""
+    import termios
+    import tty
+
+    fd = os.open(porta, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    antes = termios.tcgetattr(fd)
+    dados = bytearray()
+    try:
+        tty.setraw(fd)
+        os.write(fd, b"T")
+        fim = time.monotonic() + segundos
+        while time.monotonic() < fim:
+            try:
+                pedaco = os.read(fd, 65536)
+            except BlockingIOError:
+                pedaco = b""
+            if pedaco:
+                dados += pedaco
+            else:
+                time.sleep(0.005)
+        os.write(fd, b"t")
+    finally:
+        termios.tcsetattr(fd, termios.TCSANOW, antes)
+        os.close(fd)
+    return bytes(dados)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("entrada", nargs="?", help="arquivo capturado (- para a entrada padrão)")
+    p.add_argument("--porta", help="captura da placa por esta porta serial (ex.: /dev/ttyACM0)")
+    p.add_argument("--segundos", type=float, default=5.0, help="duração da captura (padrão: 5)")
+    p.add_argument("--bruto", help="com --porta, guarda também os bytes capturados neste arquivo")
+    p.add_argument("-o", "--saida", default="-", help="arquivo JSON (padrão: saída padrão)")
+    args = p.parse_args()
+
+    if args.porta:
+        dados = captura(args.porta, args.segundos)
+        if args.bruto:
+            with open(args.bruto, "wb") as f:
+                f.write(dados)
+    elif args.entrada in (None, "-"):
+        dados = sys.stdin.buffer.read()
+    else:
+        with open(args.entrada, "rb") as f:
+            dados = f.read()
+
+    blocos = le_blocos(dados)
+    eventos = desdobra(blocos)
+    descartados = {}
+    for nucleo, d, _ in blocos:
+        descartados[nucleo] = d   # Total desde o boot: vale o último bloco
+    print(f"{len(blocos)} blocos, {len(eventos)} eventos, descartados por anel cheio: "
+          + (", ".join(f"núcleo {n}: {d}" for n, d in sorted(descartados.items())) or "-"), file=sys.stderr)
+
+    trace = {"traceEvents": converte(eventos), "displayTimeUnit": "ms"}
+    if args.saida == "-":
+        json.dump(trace, sys.stdout)
+    else:
+        with open(args.saida, "w", encoding="utf-8") as f:
+            json.dump(trace, f)
+    return 0 if blocos else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())